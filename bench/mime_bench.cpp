@@ -0,0 +1,165 @@
+// MIME 查找的微基准：比较编译期完美哈希表（lookup_mime）与原先的 if 链
+// 用法：make bench
+#include "mime_types.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// ---- 原先 file_handlers.cpp 中的实现（仅用于对比）----
+
+// 判断文件类型（image/video/other）
+static std::string get_file_type(const std::string &ext) {
+  // 图片格式
+  if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".gif" ||
+      ext == ".bmp" || ext == ".webp" || ext == ".svg" || ext == ".ico") {
+    return "image";
+  }
+  // 视频格式
+  else if (ext == ".mp4" || ext == ".avi" || ext == ".mov" || ext == ".wmv" ||
+           ext == ".flv" || ext == ".webm" || ext == ".mkv" || ext == ".m4v" ||
+           ext == ".3gp" || ext == ".mpg" || ext == ".mpeg") {
+    return "video";
+  }
+  // 其他格式
+  return "other";
+}
+
+// 根据文件扩展名获取 Content-Type
+static std::string get_content_type(const std::string &ext) {
+  // Text types
+  if (ext == ".css") {
+    return "text/css; charset=utf-8";
+  } else if (ext == ".csv") {
+    return "text/csv; charset=utf-8";
+  } else if (ext == ".txt") {
+    return "text/plain; charset=utf-8";
+  } else if (ext == ".vtt") {
+    return "text/vtt; charset=utf-8";
+  } else if (ext == ".html" || ext == ".htm") {
+    return "text/html; charset=utf-8";
+  } else if (ext == ".js" || ext == ".mjs") {
+    return "text/javascript; charset=utf-8";
+  }
+  // Image types
+  else if (ext == ".apng") {
+    return "image/apng";
+  } else if (ext == ".avif") {
+    return "image/avif";
+  } else if (ext == ".bmp") {
+    return "image/bmp";
+  } else if (ext == ".gif") {
+    return "image/gif";
+  } else if (ext == ".png") {
+    return "image/png";
+  } else if (ext == ".svg") {
+    return "image/svg+xml";
+  } else if (ext == ".webp") {
+    return "image/webp";
+  } else if (ext == ".ico") {
+    return "image/x-icon";
+  } else if (ext == ".tif" || ext == ".tiff") {
+    return "image/tiff";
+  } else if (ext == ".jpg" || ext == ".jpeg") {
+    return "image/jpeg";
+  }
+  // Video types
+  else if (ext == ".mp4") {
+    return "video/mp4";
+  } else if (ext == ".mpeg") {
+    return "video/mpeg";
+  } else if (ext == ".webm") {
+    return "video/webm";
+  }
+  // Audio types
+  else if (ext == ".mp3") {
+    return "audio/mp3";
+  } else if (ext == ".mpga") {
+    return "audio/mpeg";
+  } else if (ext == ".weba") {
+    return "audio/webm";
+  } else if (ext == ".wav") {
+    return "audio/wave";
+  }
+  // Font types
+  else if (ext == ".otf") {
+    return "font/otf";
+  } else if (ext == ".ttf") {
+    return "font/ttf";
+  } else if (ext == ".woff") {
+    return "font/woff";
+  } else if (ext == ".woff2") {
+    return "font/woff2";
+  }
+  // Application types
+  else if (ext == ".7z") {
+    return "application/x-7z-compressed";
+  } else if (ext == ".atom") {
+    return "application/atom+xml";
+  } else if (ext == ".pdf") {
+    return "application/pdf";
+  } else if (ext == ".json") {
+    return "application/json";
+  } else if (ext == ".rss") {
+    return "application/rss+xml";
+  } else if (ext == ".tar") {
+    return "application/x-tar";
+  } else if (ext == ".xhtml" || ext == ".xht") {
+    return "application/xhtml+xml";
+  } else if (ext == ".xslt") {
+    return "application/xslt+xml";
+  } else if (ext == ".xml") {
+    return "application/xml";
+  } else if (ext == ".gz") {
+    return "application/gzip";
+  } else if (ext == ".zip") {
+    return "application/zip";
+  } else if (ext == ".wasm") {
+    return "application/wasm";
+  }
+  // 兼容旧代码中的视频格式
+  else if (ext == ".avi") {
+    return "video/x-msvideo";
+  } else if (ext == ".mov") {
+    return "video/quicktime";
+  }
+
+  return "application/octet-stream";
+}
+
+// ---- 基准 ----
+
+#define BENCH_ROUNDS 200000
+
+// 混合常见、靠后和未知的扩展名，覆盖 if 链的不同深度
+static const std::vector<std::string> BENCH_EXTENSIONS = {
+    ".png", ".jpg",  ".mp4",  ".json", ".html", ".css", ".js",  ".webm",
+    ".mov", ".wasm", ".woff2", ".zip", ".txt",  ".svg", ".exe", ".unknown"};
+
+template <typename F> static double measure(const char *name, F lookup) {
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCH_ROUNDS; ++round) {
+    for (const auto &ext : BENCH_EXTENSIONS) {
+      checksum += lookup(ext);
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() /
+              (static_cast<double>(BENCH_ROUNDS) * BENCH_EXTENSIONS.size());
+  std::printf("%-12s %8.2f ns/lookup (checksum %zu)\n", name, ns, checksum);
+  return ns;
+}
+
+int main() {
+  double legacy = measure("if-chain", [](const std::string &ext) {
+    return get_content_type(ext).size() + get_file_type(ext).size();
+  });
+  double table = measure("perfect-hash", [](const std::string &ext) {
+    const MimeInfo &info = lookup_mime(ext);
+    return std::char_traits<char>::length(info.content_type) +
+           std::char_traits<char>::length(info.file_type);
+  });
+  std::printf("speedup      %8.2fx\n", legacy / table);
+  return 0;
+}
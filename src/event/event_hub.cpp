@@ -0,0 +1,52 @@
+#include "event_hub.h"
+#include <condition_variable>
+#include <mutex>
+
+namespace {
+
+std::mutex hub_mutex;
+std::condition_variable hub_cv;
+// 事件 id 从 1 开始，id 为 n 的事件保存在 ring[n % EVENT_RING_SIZE]
+std::shared_ptr<const std::string> ring[EVENT_RING_SIZE];
+uint64_t next_id = 1;
+
+} // namespace
+
+// 发布事件
+void publish_event(const std::string &type, const nlohmann::json &data) {
+  // 在锁外序列化，订阅者只复制指针
+  std::string payload =
+      data.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+  {
+    std::lock_guard<std::mutex> lock(hub_mutex);
+    uint64_t id = next_id++;
+    ring[id % EVENT_RING_SIZE] = std::make_shared<const std::string>(
+        "id: " + std::to_string(id) + "\nevent: " + type + "\ndata: " +
+        payload + "\n\n");
+  }
+  hub_cv.notify_all();
+}
+
+// 下一个事件 id
+uint64_t next_event_id() {
+  std::lock_guard<std::mutex> lock(hub_mutex);
+  return next_id;
+}
+
+// 读取事件
+EventBatch read_events(uint64_t &cursor, std::chrono::milliseconds timeout) {
+  EventBatch batch;
+  std::unique_lock<std::mutex> lock(hub_mutex);
+  hub_cv.wait_for(lock, timeout, [&cursor] { return next_id > cursor; });
+
+  // 落后超过缓冲区大小时跳到最早仍保留的事件
+  uint64_t oldest = next_id > EVENT_RING_SIZE ? next_id - EVENT_RING_SIZE : 1;
+  if (cursor < oldest) {
+    batch.dropped = oldest - cursor;
+    cursor = oldest;
+  }
+  for (; cursor < next_id; ++cursor) {
+    batch.frames.push_back(ring[cursor % EVENT_RING_SIZE]);
+  }
+  return batch;
+}
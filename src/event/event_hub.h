@@ -0,0 +1,33 @@
+#ifndef EVENT_HUB_H
+#define EVENT_HUB_H
+
+#include <chrono>
+#include <cstdint>
+#include <json.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 环形缓冲区保留的最近事件数，订阅者落后超过该数量时丢弃较旧的事件
+#define EVENT_RING_SIZE 1024
+
+// 订阅者一次读取的结果
+struct EventBatch {
+  // 已序列化好的 SSE 帧，与其他订阅者共享
+  std::vector<std::shared_ptr<const std::string>> frames;
+  // 因消费过慢已被覆盖、未能读取到的事件数
+  uint64_t dropped = 0;
+};
+
+// 发布一个事件：只序列化一次（含 id、event、data 字段），
+// 写入所有订阅者共享的环形缓冲区并唤醒等待中的订阅者
+void publish_event(const std::string &type, const nlohmann::json &data);
+
+// 下一个将要发布的事件 id（新订阅者从这里开始读取）
+uint64_t next_event_id();
+
+// 从 cursor（下一个要读取的事件 id）开始读取所有已发布的事件，
+// 没有新事件时最多等待 timeout；返回后 cursor 指向下一个要读取的事件
+EventBatch read_events(uint64_t &cursor, std::chrono::milliseconds timeout);
+
+#endif // EVENT_HUB_H
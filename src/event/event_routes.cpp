@@ -0,0 +1,88 @@
+#include "event_routes.h"
+#include "../worker_budget.h"
+#include "event_hub.h"
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+using json = nlohmann::json;
+
+// 没有事件时发送保活注释的间隔（秒），同时用于发现已断开的连接
+#define EVENT_KEEPALIVE_SECONDS 15
+// 建议浏览器断线后重连的等待时间（毫秒）
+#define EVENT_RETRY_MS 3000
+
+struct EventStreamState {
+  std::shared_ptr<WorkerLease> lease; // 连接期间占用的工作线程名额
+  uint64_t cursor; // 下一个要发送的事件 id
+  bool started = false;
+};
+
+// 处理 /api/events 请求（订阅服务器事件）
+void handle_events(const httplib::Request &req, httplib::Response &res) {
+  // 订阅连接在整个期间占用一个工作线程（阻塞在事件缓冲区上等待新事件），
+  // 从工作线程名额中申请，名额已满时拒绝
+  std::shared_ptr<WorkerLease> lease = acquire_worker_lease();
+  if (!lease) {
+    res.status = 503;
+    res.set_header("Retry-After", "1");
+    res.set_content("{\"error\":\"Too many event streams\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
+
+  // 断线重连时浏览器带上 Last-Event-ID，从其后一个事件继续发送
+  uint64_t next_id = next_event_id();
+  auto state = std::make_shared<EventStreamState>();
+  state->lease = std::move(lease);
+  state->cursor = next_id;
+  std::string last_id = req.get_header_value("Last-Event-ID");
+  if (!last_id.empty()) {
+    char *end = nullptr;
+    unsigned long long id = std::strtoull(last_id.c_str(), &end, 10);
+    if (*end == '\0' && id < next_id) {
+      state->cursor = id + 1;
+    }
+  }
+
+  res.set_header("Cache-Control", "no-cache");
+  res.set_chunked_content_provider(
+      "text/event-stream; charset=utf-8",
+      [state]([[maybe_unused]] size_t offset, httplib::DataSink &sink) {
+        // 首次调用立即发送重连间隔，使响应头和连接状态尽快到达客户端
+        if (!state->started) {
+          state->started = true;
+          std::string line =
+              "retry: " + std::to_string(EVENT_RETRY_MS) + "\n\n";
+          return sink.write(line.data(), line.size());
+        }
+
+        EventBatch batch = read_events(
+            state->cursor, std::chrono::seconds(EVENT_KEEPALIVE_SECONDS));
+
+        // 消费过慢时较旧的事件已被覆盖，通知客户端重新拉取完整列表
+        if (batch.dropped > 0) {
+          std::string line = "event: dropped\ndata: " +
+                             json{{"count", batch.dropped}}.dump() + "\n\n";
+          if (!sink.write(line.data(), line.size())) {
+            return false;
+          }
+        }
+        if (batch.frames.empty() && batch.dropped == 0) {
+          static const std::string keepalive = ": keepalive\n\n";
+          return sink.write(keepalive.data(), keepalive.size());
+        }
+        for (const auto &frame : batch.frames) {
+          if (!sink.write(frame->data(), frame->size())) {
+            return false;
+          }
+        }
+        return true;
+      },
+      nullptr);
+}
+
+// 配置事件推送相关路由
+void configure_event_routes(httplib::Server &server) {
+  server.Get("/api/events", handle_events);
+}
@@ -0,0 +1,9 @@
+#ifndef EVENT_ROUTES_H
+#define EVENT_ROUTES_H
+
+#include <httplib.h>
+
+// 配置事件推送相关路由
+void configure_event_routes(httplib::Server &server);
+
+#endif // EVENT_ROUTES_H
@@ -0,0 +1,221 @@
+#include "compression.h"
+#include <algorithm>
+#include <brotli/encode.h>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+// 压缩、解压时每次输出的缓冲区大小
+#define INFLATE_BUFFER_SIZE (64 * 1024)
+
+// 使用 brotli 最高压缩等级的文件大小上限
+#define BROTLI_MAX_QUALITY_SIZE (8 * 1024 * 1024)
+
+// 判断 Content-Type 是否值得压缩（文本、JSON、SVG、JS、CSS 等）
+bool is_compressible_type(const std::string &content_type) {
+  std::string mime = content_type.substr(0, content_type.find(';'));
+  if (mime.rfind("text/", 0) == 0) {
+    return true;
+  }
+  return mime == "application/json" || mime == "application/javascript" ||
+         mime == "application/xml" || mime == "application/xhtml+xml" ||
+         mime == "application/atom+xml" || mime == "application/rss+xml" ||
+         mime == "application/xslt+xml" || mime == "application/wasm" ||
+         mime == "image/svg+xml";
+}
+
+// 判断 Accept-Encoding 请求头是否接受指定编码（支持 q=0 排除）；
+// 明确列出的编码优先于通配符（RFC 9110），如 "*;q=0, br" 接受 br
+bool accepts_encoding(const std::string &accept_encoding,
+                      const std::string &coding) {
+  bool wildcard = false; // 通配符 * 是否接受未明确列出的编码
+  size_t pos = 0;
+  while (pos < accept_encoding.size()) {
+    size_t end = accept_encoding.find(',', pos);
+    if (end == std::string::npos) {
+      end = accept_encoding.size();
+    }
+    std::string item = accept_encoding.substr(pos, end - pos);
+    pos = end + 1;
+
+    // 拆分编码名与参数（如 "gzip;q=0.5"）
+    std::string name = item.substr(0, item.find(';'));
+    name.erase(std::remove_if(name.begin(), name.end(),
+                              [](unsigned char c) { return std::isspace(c); }),
+               name.end());
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    if (name != coding && name != "*") {
+      continue;
+    }
+
+    size_t q = item.find("q=");
+    bool accepted = q == std::string::npos ||
+                    std::strtod(item.c_str() + q + 2, nullptr) > 0;
+    if (name == coding) {
+      return accepted;
+    }
+    wildcard = accepted;
+  }
+  return wildcard;
+}
+
+struct StreamCompressor::State {
+  bool brotli = false;
+  z_stream strm;
+  BrotliEncoderState *encoder = nullptr;
+  char buffer[INFLATE_BUFFER_SIZE];
+};
+
+StreamCompressor::StreamCompressor(const std::string &coding, size_t size)
+    : state_(new State) {
+  if (coding == "br") {
+    state_->brotli = true;
+    state_->encoder = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+    if (!state_->encoder) {
+      state_.reset();
+      return;
+    }
+    // 大文件使用较低等级，避免后台压缩占用过长时间
+    uint32_t quality = size <= BROTLI_MAX_QUALITY_SIZE ? BROTLI_MAX_QUALITY : 9;
+    BrotliEncoderSetParameter(state_->encoder, BROTLI_PARAM_QUALITY, quality);
+    BrotliEncoderSetParameter(state_->encoder, BROTLI_PARAM_MODE,
+                              BROTLI_MODE_TEXT);
+    BrotliEncoderSetParameter(state_->encoder, BROTLI_PARAM_SIZE_HINT,
+                              static_cast<uint32_t>((std::min)(
+                                  size, static_cast<size_t>(1u << 30))));
+    return;
+  }
+
+  std::memset(&state_->strm, 0, sizeof(state_->strm));
+  // windowBits 加 16 表示输出 gzip 格式
+  if (deflateInit2(&state_->strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16,
+                   8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    state_.reset();
+  }
+}
+
+StreamCompressor::~StreamCompressor() {
+  if (!state_) {
+    return;
+  }
+  if (state_->brotli) {
+    BrotliEncoderDestroyInstance(state_->encoder);
+  } else {
+    deflateEnd(&state_->strm);
+  }
+}
+
+// 输入一块原始数据
+bool StreamCompressor::compress(const char *data, size_t len,
+                                const Callback &callback) {
+  return run(data, len, false, callback);
+}
+
+// 结束压缩流
+bool StreamCompressor::finish(const Callback &callback) {
+  return run(nullptr, 0, true, callback);
+}
+
+// 压缩输入数据直到全部消耗（finish 时直到压缩流结束），每填满一次缓冲区输出一次
+bool StreamCompressor::run(const char *data, size_t len, bool finish,
+                           const Callback &callback) {
+  if (!state_) {
+    return false;
+  }
+
+  if (state_->brotli) {
+    BrotliEncoderOperation op =
+        finish ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS;
+    size_t avail_in = len;
+    const uint8_t *next_in = reinterpret_cast<const uint8_t *>(data);
+    while (true) {
+      size_t avail_out = INFLATE_BUFFER_SIZE;
+      uint8_t *next_out = reinterpret_cast<uint8_t *>(state_->buffer);
+      if (!BrotliEncoderCompressStream(state_->encoder, op, &avail_in,
+                                       &next_in, &avail_out, &next_out,
+                                       nullptr)) {
+        return false;
+      }
+      size_t produced = INFLATE_BUFFER_SIZE - avail_out;
+      if (produced > 0 && !callback(state_->buffer, produced)) {
+        return false;
+      }
+      bool done = finish ? BrotliEncoderIsFinished(state_->encoder)
+                         : avail_in == 0;
+      if (done && !BrotliEncoderHasMoreOutput(state_->encoder)) {
+        return true;
+      }
+    }
+  }
+
+  z_stream &strm = state_->strm;
+  strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  strm.avail_in = static_cast<uInt>(len);
+  while (true) {
+    strm.next_out = reinterpret_cast<Bytef *>(state_->buffer);
+    strm.avail_out = INFLATE_BUFFER_SIZE;
+    int ret = deflate(&strm, finish ? Z_FINISH : Z_NO_FLUSH);
+    if (ret == Z_STREAM_ERROR) {
+      return false;
+    }
+    size_t produced = INFLATE_BUFFER_SIZE - strm.avail_out;
+    if (produced > 0 && !callback(state_->buffer, produced)) {
+      return false;
+    }
+    if (finish ? ret == Z_STREAM_END
+               : strm.avail_in == 0 && strm.avail_out != 0) {
+      return true;
+    }
+  }
+}
+
+struct GzipInflater::State {
+  z_stream strm;
+  char buffer[INFLATE_BUFFER_SIZE];
+};
+
+GzipInflater::GzipInflater() : state_(new State) {
+  std::memset(&state_->strm, 0, sizeof(state_->strm));
+  if (inflateInit2(&state_->strm, 15 + 16) != Z_OK) {
+    state_.reset();
+  }
+}
+
+GzipInflater::~GzipInflater() {
+  if (state_) {
+    inflateEnd(&state_->strm);
+  }
+}
+
+// 输入一块压缩数据，回调返回 false 或数据损坏时返回 false
+bool GzipInflater::inflate(const char *data, size_t len,
+                           const Callback &callback) {
+  if (!state_) {
+    return false;
+  }
+  z_stream &strm = state_->strm;
+  strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  strm.avail_in = static_cast<uInt>(len);
+
+  while (!finished_ && (strm.avail_in > 0 || len == 0)) {
+    strm.next_out = reinterpret_cast<Bytef *>(state_->buffer);
+    strm.avail_out = INFLATE_BUFFER_SIZE;
+
+    int ret = ::inflate(&strm, Z_NO_FLUSH);
+    if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+      return false;
+    }
+    size_t produced = INFLATE_BUFFER_SIZE - strm.avail_out;
+    if (produced > 0 && !callback(state_->buffer, produced)) {
+      return false;
+    }
+    if (ret == Z_STREAM_END) {
+      finished_ = true;
+    } else if (produced == 0) {
+      break; // 需要更多输入
+    }
+  }
+  return true;
+}
@@ -0,0 +1,70 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+// 小于该大小的文件不压缩存储（收益太小）
+#define MIN_COMPRESS_SIZE 1024
+// 超过该大小的文件不生成预压缩变体，直接发送原始内容或存储的 gzip 数据
+#define MAX_PRECOMPRESS_SIZE (64 * 1024 * 1024) // 64MB
+
+// 判断 Content-Type 是否值得压缩（文本、JSON、SVG、JS、CSS 等）
+bool is_compressible_type(const std::string &content_type);
+
+// 判断 Accept-Encoding 请求头是否接受指定编码（支持 q=0 排除）
+bool accepts_encoding(const std::string &accept_encoding,
+                      const std::string &coding);
+
+// 流式压缩器（coding 为 "br" 或 "gzip"），按块输入原始数据，压缩结果通过回调输出，
+// 内存占用与文件大小无关；size 为原始数据总大小，用于选择 brotli 压缩等级
+class StreamCompressor {
+public:
+  using Callback = std::function<bool(const char *data, size_t len)>;
+
+  StreamCompressor(const std::string &coding, size_t size);
+  ~StreamCompressor();
+
+  StreamCompressor(const StreamCompressor &) = delete;
+  StreamCompressor &operator=(const StreamCompressor &) = delete;
+
+  // 输入一块原始数据，回调返回 false 或压缩失败时返回 false
+  bool compress(const char *data, size_t len, const Callback &callback);
+
+  // 结束压缩流，输出剩余的压缩数据
+  bool finish(const Callback &callback);
+
+private:
+  bool run(const char *data, size_t len, bool finish,
+           const Callback &callback);
+
+  struct State;
+  std::unique_ptr<State> state_;
+};
+
+// 流式 gzip 解压器，按块输入压缩数据，解压结果通过回调输出
+class GzipInflater {
+public:
+  using Callback = std::function<bool(const char *data, size_t len)>;
+
+  GzipInflater();
+  ~GzipInflater();
+
+  GzipInflater(const GzipInflater &) = delete;
+  GzipInflater &operator=(const GzipInflater &) = delete;
+
+  // 输入一块压缩数据，回调返回 false 或数据损坏时返回 false
+  bool inflate(const char *data, size_t len, const Callback &callback);
+
+  // 压缩流是否已经结束
+  bool finished() const { return finished_; }
+
+private:
+  struct State;
+  std::unique_ptr<State> state_;
+  bool finished_ = false;
+};
+
+#endif // COMPRESSION_H
@@ -0,0 +1,182 @@
+#include "file_cache.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// 频率统计草图参数：每行计数器数量（2 的幂）及行数
+#define SKETCH_WIDTH 4096
+#define SKETCH_DEPTH 4
+// 计数器上限（4 位饱和计数）
+#define SKETCH_MAX_COUNT 15
+
+namespace {
+
+// Count-Min Sketch：以很小的固定内存近似统计每个 key 的访问次数，
+// 累计记录一定次数后所有计数减半，让过去的热点逐渐冷却
+class FrequencySketch {
+public:
+  FrequencySketch() : counters_(SKETCH_WIDTH * SKETCH_DEPTH, 0) {}
+
+  void increment(size_t hash) {
+    // 保守更新：只增加等于当前最小值的计数器，降低高估
+    uint8_t min = frequency(hash);
+    if (min >= SKETCH_MAX_COUNT) {
+      return;
+    }
+    for (int row = 0; row < SKETCH_DEPTH; ++row) {
+      uint8_t &counter = counters_[index(hash, row)];
+      if (counter == min) {
+        counter++;
+      }
+    }
+
+    if (++additions_ >= SKETCH_WIDTH * 10) {
+      for (auto &counter : counters_) {
+        counter >>= 1;
+      }
+      additions_ /= 2;
+    }
+  }
+
+  uint8_t frequency(size_t hash) const {
+    uint8_t min = SKETCH_MAX_COUNT;
+    for (int row = 0; row < SKETCH_DEPTH; ++row) {
+      min = (std::min)(min, counters_[index(hash, row)]);
+    }
+    return min;
+  }
+
+private:
+  static size_t index(size_t hash, int row) {
+    static const uint64_t seeds[SKETCH_DEPTH] = {
+        0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL,
+        0xD6E8FEB86659FD93ULL};
+    uint64_t h = (static_cast<uint64_t>(hash) ^ seeds[row]) * seeds[row];
+    return row * SKETCH_WIDTH + ((h >> 32) & (SKETCH_WIDTH - 1));
+  }
+
+  std::vector<uint8_t> counters_;
+  size_t additions_ = 0;
+};
+
+struct CacheEntry {
+  std::string owner;
+  std::shared_ptr<const std::string> content;
+  std::list<std::string>::iterator lru_pos;
+};
+
+// 缓存分片：每个分片独立加锁，拥有自己的 LRU 队列和频率草图
+struct CacheShard {
+  std::mutex mutex;
+  std::list<std::string> lru; // 头部为最近使用
+  std::unordered_map<std::string, CacheEntry> entries;
+  size_t bytes = 0;
+  FrequencySketch sketch;
+};
+
+std::array<CacheShard, FILE_CACHE_SHARDS> shards;
+
+const size_t SHARD_MAX_BYTES = FILE_CACHE_MAX_BYTES / FILE_CACHE_SHARDS;
+
+// 每个文件的缓存版本号，失效时递增，用于丢弃失效前开始读取的内容
+std::mutex generation_mutex;
+std::unordered_map<std::string, uint64_t> generations;
+
+} // namespace
+
+static CacheShard &shard_for(size_t hash) {
+  return shards[hash % FILE_CACHE_SHARDS];
+}
+
+// 查找缓存的文件内容（同时记录访问频率），未命中返回 nullptr
+std::shared_ptr<const std::string> file_cache_get(const std::string &key) {
+  size_t hash = std::hash<std::string>()(key);
+  CacheShard &shard = shard_for(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  shard.sketch.increment(hash);
+  auto it = shard.entries.find(key);
+  if (it == shard.entries.end()) {
+    return nullptr;
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_pos);
+  return it->second.content;
+}
+
+// 获取文件当前的缓存版本号
+uint64_t file_cache_generation(const std::string &owner) {
+  std::lock_guard<std::mutex> lock(generation_mutex);
+  auto it = generations.find(owner);
+  return it == generations.end() ? 0 : it->second;
+}
+
+// 尝试缓存文件内容（TinyLFU 准入）
+void file_cache_put(const std::string &key, const std::string &owner,
+                    uint64_t generation,
+                    std::shared_ptr<const std::string> content) {
+  size_t size = content->size();
+  if (size > FILE_CACHE_MAX_ENTRY_SIZE || size > SHARD_MAX_BYTES) {
+    return;
+  }
+
+  size_t hash = std::hash<std::string>()(key);
+  CacheShard &shard = shard_for(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  // 持有分片锁检查版本号：失效先递增版本号再清理分片，
+  // 因此过期内容要么在这里被拒绝，要么放入后被随后的清理删除
+  if (shard.entries.count(key) || file_cache_generation(owner) != generation) {
+    return;
+  }
+
+  // 找出为腾出空间需要淘汰的 LRU 尾部条目；
+  // 只要其中有一个比新内容访问更频繁，就拒绝放入，保护现有热点
+  uint8_t candidate_freq = shard.sketch.frequency(hash);
+  size_t freed = 0;
+  size_t victims = 0;
+  for (auto it = shard.lru.rbegin();
+       it != shard.lru.rend() && shard.bytes - freed + size > SHARD_MAX_BYTES;
+       ++it, ++victims) {
+    if (shard.sketch.frequency(std::hash<std::string>()(*it)) >=
+        candidate_freq) {
+      return;
+    }
+    freed += shard.entries[*it].content->size();
+  }
+
+  for (; victims > 0; --victims) {
+    auto victim = shard.entries.find(shard.lru.back());
+    shard.bytes -= victim->second.content->size();
+    shard.entries.erase(victim);
+    shard.lru.pop_back();
+  }
+
+  shard.lru.push_front(key);
+  shard.entries[key] = {owner, std::move(content), shard.lru.begin()};
+  shard.bytes += size;
+}
+
+// 使某个文件的所有缓存内容失效
+void file_cache_invalidate(const std::string &owner) {
+  {
+    std::lock_guard<std::mutex> lock(generation_mutex);
+    generations[owner]++;
+  }
+  for (auto &shard : shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+      if (it->second.owner == owner) {
+        shard.bytes -= it->second.content->size();
+        shard.lru.erase(it->second.lru_pos);
+        it = shard.entries.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 热点文件内存缓存配置
+#define FILE_CACHE_MAX_BYTES (128LL * 1024 * 1024)  // 缓存总大小上限 128MB
+#define FILE_CACHE_MAX_ENTRY_SIZE (2 * 1024 * 1024) // 单个文件上限 2MB
+#define FILE_CACHE_SHARDS 16                        // 分片数，降低锁竞争
+
+// 查找缓存的文件内容（同时记录访问频率），未命中返回 nullptr
+// key 为文件路径，同一文件的不同表示（原文件、压缩变体）分别缓存
+std::shared_ptr<const std::string> file_cache_get(const std::string &key);
+
+// 获取文件当前的缓存版本号，每次失效时递增；
+// 读取文件内容之前取得，放入缓存时用于判断内容是否已过期
+uint64_t file_cache_generation(const std::string &owner);
+
+// 尝试缓存文件内容：空间不足时按 TinyLFU 比较访问频率，
+// 新内容比将被淘汰的内容更常用才会放入缓存
+// owner 为所属文件名，用于删除文件时使其所有表示失效；
+// generation 为读取前取得的版本号，读取期间文件已失效（如删除后重新上传）时不放入
+void file_cache_put(const std::string &key, const std::string &owner,
+                    uint64_t generation,
+                    std::shared_ptr<const std::string> content);
+
+// 使某个文件的所有缓存内容失效，并递增其版本号
+void file_cache_invalidate(const std::string &owner);
+
+#endif // FILE_CACHE_H
@@ -0,0 +1,187 @@
+#include "file_handle_cache.h"
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+struct HandleEntry {
+  std::shared_ptr<const FileHandle> handle;
+  std::list<std::string>::iterator lru_pos;
+};
+
+std::mutex handle_mutex;
+std::list<std::string> lru; // 头部为最近使用
+std::unordered_map<std::string, HandleEntry> handles;
+
+// 每个文件的版本号，失效时递增；清空整个缓存时递增 clear_generation。
+// 在锁外打开文件期间版本号发生变化时，打开的句柄可能指向失效前的文件，不放入缓存
+std::unordered_map<std::string, uint64_t> generations;
+uint64_t clear_generation = 0;
+
+} // namespace
+
+// 获取文件当前的版本号（需持有锁），从未失效过的文件为 0，
+// 不为请求的文件名创建条目
+static uint64_t generation_locked(const std::string &filename) {
+  auto it = generations.find(filename);
+  return it == generations.end() ? 0 : it->second;
+}
+
+FileHandle::~FileHandle() {
+#ifndef _WIN32
+  if (fd != -1) {
+    ::close(fd);
+  }
+#endif
+}
+
+// 打开文件并读取状态
+static std::shared_ptr<FileHandle> open_file_handle(const std::string &path) {
+  auto handle = std::make_shared<FileHandle>();
+  handle->path = path;
+  struct stat st;
+#ifdef _WIN32
+  if (stat(path.c_str(), &st) != 0) {
+    return nullptr;
+  }
+#else
+  handle->fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (handle->fd == -1 || fstat(handle->fd, &st) != 0) {
+    return nullptr;
+  }
+#endif
+  if (!S_ISREG(st.st_mode)) {
+    return nullptr;
+  }
+  handle->size = static_cast<size_t>(st.st_size);
+  handle->mtime = st.st_mtime;
+  return handle;
+}
+
+// 获取 assets 目录下文件的句柄
+std::shared_ptr<const FileHandle>
+acquire_file_handle(const std::string &filename) {
+  uint64_t generation, cleared;
+  {
+    std::lock_guard<std::mutex> lock(handle_mutex);
+    auto it = handles.find(filename);
+    if (it != handles.end()) {
+      lru.splice(lru.begin(), lru, it->second.lru_pos);
+      return it->second.handle;
+    }
+    generation = generation_locked(filename);
+    cleared = clear_generation;
+  }
+
+  // 在锁外打开文件，避免阻塞其他请求
+  std::shared_ptr<const FileHandle> handle =
+      open_file_handle((std::filesystem::path("assets") / filename).string());
+  if (!handle) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(handle_mutex);
+  auto it = handles.find(filename);
+  if (it != handles.end()) {
+    return it->second.handle; // 其他请求已经打开
+  }
+  // 打开期间文件已失效（如被删除）：本次请求仍使用打开的句柄，
+  // 但不放入缓存，避免之后的请求拿到已删除的文件
+  if (generation_locked(filename) != generation || clear_generation != cleared) {
+    return handle;
+  }
+  lru.push_front(filename);
+  handles[filename] = {handle, lru.begin()};
+
+  // 超出上限时关闭最久未使用的文件（仍在使用中的句柄由 shared_ptr 保持打开）
+  while (handles.size() > FILE_HANDLE_CACHE_SIZE) {
+    handles.erase(lru.back());
+    lru.pop_back();
+  }
+  return handle;
+}
+
+// 使某个文件的句柄缓存失效
+void invalidate_file_handle(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(handle_mutex);
+  generations[filename]++;
+  auto it = handles.find(filename);
+  if (it != handles.end()) {
+    lru.erase(it->second.lru_pos);
+    handles.erase(it);
+  }
+}
+
+// 清空句柄缓存（仍在使用中的句柄由 shared_ptr 保持打开）
+static void clear_file_handles() {
+  std::lock_guard<std::mutex> lock(handle_mutex);
+  clear_generation++;
+  handles.clear();
+  lru.clear();
+}
+
+// 监听 assets 目录的外部修改
+bool watch_assets_changes(std::function<void(const std::string &)> listener,
+                          std::function<void()> overflow) {
+#ifdef __linux__
+  std::error_code ec;
+  std::filesystem::create_directories("assets", ec);
+
+  int fd = inotify_init1(IN_CLOEXEC);
+  if (fd == -1 ||
+      inotify_add_watch(fd, "assets",
+                        IN_CREATE | IN_CLOSE_WRITE | IN_DELETE |
+                            IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB) == -1) {
+    std::cerr << "Warning: failed to watch assets directory" << std::endl;
+    if (fd != -1) {
+      ::close(fd);
+    }
+    return false;
+  }
+
+  std::thread([fd, listener = std::move(listener),
+               overflow = std::move(overflow)]() {
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    while (true) {
+      ssize_t len = ::read(fd, buffer, sizeof(buffer));
+      if (len <= 0) {
+        break;
+      }
+      for (char *p = buffer; p < buffer + len;) {
+        auto *event = reinterpret_cast<struct inotify_event *>(p);
+        if (event->mask & IN_Q_OVERFLOW) {
+          // 事件已丢失，无法知道哪些文件变化，全部重新加载
+          clear_file_handles();
+          overflow();
+        } else if (event->len > 0) {
+          std::string filename(event->name);
+          invalidate_file_handle(filename);
+          listener(filename);
+        }
+        p += sizeof(struct inotify_event) + event->len;
+      }
+    }
+    ::close(fd);
+  }).detach();
+  return true;
+#else
+  (void)listener; // 其他平台只依赖上传/删除时的主动失效
+  (void)overflow;
+  return false;
+#endif
+}
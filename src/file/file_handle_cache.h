@@ -0,0 +1,40 @@
+#ifndef FILE_HANDLE_CACHE_H
+#define FILE_HANDLE_CACHE_H
+
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+
+// 最多缓存的打开文件数
+#define FILE_HANDLE_CACHE_SIZE 256
+
+// 已打开的文件及其状态（析构时关闭文件）
+struct FileHandle {
+  std::string path;
+  int fd = -1; // Windows 下不保持打开，始终为 -1
+  size_t size = 0;
+  time_t mtime = 0;
+
+  FileHandle() = default;
+  FileHandle(const FileHandle &) = delete;
+  FileHandle &operator=(const FileHandle &) = delete;
+  ~FileHandle();
+};
+
+// 获取 assets 目录下文件的句柄：命中时不产生任何系统调用，
+// 未命中时打开文件并记录大小和修改时间；文件不存在或不是普通文件时返回 nullptr
+std::shared_ptr<const FileHandle>
+acquire_file_handle(const std::string &filename);
+
+// 使某个文件的句柄缓存失效（上传、删除、修改后调用）
+void invalidate_file_handle(const std::string &filename);
+
+// 监听 assets 目录的外部修改（Linux 下使用 inotify），
+// 文件被创建（含硬链接）、修改、删除或重命名时以文件名调用 listener；
+// 事件队列溢出（可能丢失了部分事件）时清空句柄缓存并调用 overflow；
+// 当前平台不支持或监听失败时返回 false
+bool watch_assets_changes(std::function<void(const std::string &)> listener,
+                          std::function<void()> overflow);
+
+#endif // FILE_HANDLE_CACHE_H
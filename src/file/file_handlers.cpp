@@ -1,134 +1,37 @@
 #include "file_handlers.h"
+#include "../event/event_hub.h"
+#include "compression.h"
+#include "file_cache.h"
+#include "file_handle_cache.h"
+#include "file_index.h"
 #include "file_manager.h"
+#include "image_info.h"
+#include "image_resize.h"
+#include "mapped_file.h"
+#include "mime_types.h"
+#include "mp4_info.h"
+#include "rate_limiter.h"
+#include "readahead.h"
+#include "sha256.h"
+#include "single_flight.h"
+#include "variant_cache.h"
+#include "zip_stream.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <set>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <json.hpp>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <vector>
 
 using json = nlohmann::json;
 
-// 判断文件类型（image/video/other）
-static std::string get_file_type(const std::string &ext) {
-  // 图片格式
-  if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".gif" ||
-      ext == ".bmp" || ext == ".webp" || ext == ".svg" || ext == ".ico") {
-    return "image";
-  }
-  // 视频格式
-  else if (ext == ".mp4" || ext == ".avi" || ext == ".mov" || ext == ".wmv" ||
-           ext == ".flv" || ext == ".webm" || ext == ".mkv" || ext == ".m4v" ||
-           ext == ".3gp" || ext == ".mpg" || ext == ".mpeg") {
-    return "video";
-  }
-  // 其他格式
-  return "other";
-}
-
-// 根据文件扩展名获取 Content-Type
-static std::string get_content_type(const std::filesystem::path &filepath) {
-  std::string ext = filepath.extension().string();
-
-  // Text types
-  if (ext == ".css") {
-    return "text/css; charset=utf-8";
-  } else if (ext == ".csv") {
-    return "text/csv; charset=utf-8";
-  } else if (ext == ".txt") {
-    return "text/plain; charset=utf-8";
-  } else if (ext == ".vtt") {
-    return "text/vtt; charset=utf-8";
-  } else if (ext == ".html" || ext == ".htm") {
-    return "text/html; charset=utf-8";
-  } else if (ext == ".js" || ext == ".mjs") {
-    return "text/javascript; charset=utf-8";
-  }
-  // Image types
-  else if (ext == ".apng") {
-    return "image/apng";
-  } else if (ext == ".avif") {
-    return "image/avif";
-  } else if (ext == ".bmp") {
-    return "image/bmp";
-  } else if (ext == ".gif") {
-    return "image/gif";
-  } else if (ext == ".png") {
-    return "image/png";
-  } else if (ext == ".svg") {
-    return "image/svg+xml";
-  } else if (ext == ".webp") {
-    return "image/webp";
-  } else if (ext == ".ico") {
-    return "image/x-icon";
-  } else if (ext == ".tif" || ext == ".tiff") {
-    return "image/tiff";
-  } else if (ext == ".jpg" || ext == ".jpeg") {
-    return "image/jpeg";
-  }
-  // Video types
-  else if (ext == ".mp4") {
-    return "video/mp4";
-  } else if (ext == ".mpeg") {
-    return "video/mpeg";
-  } else if (ext == ".webm") {
-    return "video/webm";
-  }
-  // Audio types
-  else if (ext == ".mp3") {
-    return "audio/mp3";
-  } else if (ext == ".mpga") {
-    return "audio/mpeg";
-  } else if (ext == ".weba") {
-    return "audio/webm";
-  } else if (ext == ".wav") {
-    return "audio/wave";
-  }
-  // Font types
-  else if (ext == ".otf") {
-    return "font/otf";
-  } else if (ext == ".ttf") {
-    return "font/ttf";
-  } else if (ext == ".woff") {
-    return "font/woff";
-  } else if (ext == ".woff2") {
-    return "font/woff2";
-  }
-  // Application types
-  else if (ext == ".7z") {
-    return "application/x-7z-compressed";
-  } else if (ext == ".atom") {
-    return "application/atom+xml";
-  } else if (ext == ".pdf") {
-    return "application/pdf";
-  } else if (ext == ".json") {
-    return "application/json";
-  } else if (ext == ".rss") {
-    return "application/rss+xml";
-  } else if (ext == ".tar") {
-    return "application/x-tar";
-  } else if (ext == ".xhtml" || ext == ".xht") {
-    return "application/xhtml+xml";
-  } else if (ext == ".xslt") {
-    return "application/xslt+xml";
-  } else if (ext == ".xml") {
-    return "application/xml";
-  } else if (ext == ".gz") {
-    return "application/gzip";
-  } else if (ext == ".zip") {
-    return "application/zip";
-  } else if (ext == ".wasm") {
-    return "application/wasm";
-  }
-  // 兼容旧代码中的视频格式
-  else if (ext == ".avi") {
-    return "video/x-msvideo";
-  } else if (ext == ".mov") {
-    return "video/quicktime";
-  }
-
-  return "application/octet-stream";
-}
-
 // 验证文件名是否安全（防止路径遍历攻击）
 static bool is_valid_filename(const std::string &filename) {
   return filename.find("..") == std::string::npos &&
@@ -136,6 +39,405 @@ static bool is_valid_filename(const std::string &filename) {
          filename.find("\\") == std::string::npos;
 }
 
+// 解析缩放宽度参数（1~MAX_RESIZE_WIDTH 的十进制整数），非法时返回 0
+static int parse_resize_width(const std::string &value) {
+  if (value.empty() || value.size() > 4 ||
+      value.find_first_not_of("0123456789") != std::string::npos) {
+    return 0;
+  }
+  int width = std::stoi(value);
+  return width <= MAX_RESIZE_WIDTH ? width : 0;
+}
+
+// 获取源图片宽度：优先使用上传时记录在元数据中的宽度，
+// 没有记录（旧元数据或直接放入的文件）时读取文件头，失败返回 0
+static int read_source_width(const std::filesystem::path &filepath,
+                             const json &metadata) {
+  if (metadata.is_object() && metadata.value("width", 0) > 0) {
+    return metadata.value("width", 0);
+  }
+  char header[64];
+  std::ifstream file(filepath, std::ios::binary);
+  file.read(header, sizeof(header));
+  std::string_view data(header, static_cast<size_t>(file.gcount()));
+  int width = 0, height = 0;
+  if (!read_image_size(data, width, height)) {
+    return 0;
+  }
+  return width;
+}
+
+// 获取图片的缩放变体（仅支持 PNG 且只缩小不放大），不适用时返回 false
+static bool get_resized_variant(const std::filesystem::path &filepath,
+                                const std::string &filename,
+                                const json &metadata, int width,
+                                std::filesystem::path &variant_path) {
+  if (filepath.extension().string() != ".png") {
+    return false;
+  }
+  int source_width = read_source_width(filepath, metadata);
+  if (source_width <= 0 || width >= source_width) {
+    return false;
+  }
+
+  std::string variant = "w" + std::to_string(width) + ".png";
+  return get_or_create_variant(
+      filename, variant,
+      [&filepath, width](const VariantWriter &write) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file.is_open()) {
+          return false;
+        }
+        std::string content((std::istreambuf_iterator<char>(file)),
+                            std::istreambuf_iterator<char>());
+        Image source, resized;
+        std::string png;
+        if (!decode_png(content, source)) {
+          return false;
+        }
+        resize_image(source, width, resized);
+        return encode_png(resized, png) && write(png.data(), png.size());
+      },
+      variant_path);
+}
+
+// 写入数据：需要限速时分成小块，每块发送前等待令牌
+static bool write_throttled(httplib::DataSink &sink, Throttle *throttle,
+                            const char *data, size_t len) {
+  if (!throttle) {
+    return sink.write(data, len);
+  }
+  while (len > 0) {
+    size_t n = (std::min)(len, static_cast<size_t>(RATE_LIMIT_CHUNK_SIZE));
+    throttle->acquire(n);
+    if (!sink.write(data, n)) {
+      return false;
+    }
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+// 从内存发送文件内容（支持 Range），多个请求共享同一份只读数据
+static void send_content(httplib::Response &res,
+                         std::shared_ptr<const std::string> content,
+                         const std::string &content_type,
+                         std::shared_ptr<Throttle> throttle) {
+  res.set_header("Accept-Ranges", "bytes");
+  if (content->empty()) {
+    res.set_content("", content_type);
+    return;
+  }
+
+  res.set_content_provider(
+      content->size(), content_type,
+      [content, throttle](size_t offset, size_t length,
+                          httplib::DataSink &sink) {
+        return write_throttled(sink, throttle.get(), content->data() + offset,
+                               length);
+      });
+}
+
+// 发送文件：热点小文件用 pread 读入内存缓存后发送；其余文件通过内容提供器
+// 按固定窗口映射并直接从映射页写入 socket，数据不经过用户态缓冲区复制，
+// 每个连接只占用一个窗口的映射；Range 请求由 httplib 按区间调用内容提供器
+// owner 为文件所属的文件名，用于删除时清理缓存；
+// generation 为打开文件之前取得的缓存版本号，读取期间文件失效时结果不放入缓存；
+// throttle 为下载限速器（不限速时为 nullptr）；
+// handle 为句柄缓存中已打开的同一文件，传入时不再重新打开；
+// readahead 为区间请求的预读状态，传入时在发送过程中提前异步预读后续数据
+static void send_file(httplib::Response &res,
+                      const std::filesystem::path &filepath,
+                      const std::string &content_type,
+                      const std::string &owner, uint64_t generation,
+                      std::shared_ptr<Throttle> throttle,
+                      std::shared_ptr<const FileHandle> handle = nullptr,
+                      std::shared_ptr<Readahead> readahead = nullptr) {
+  std::string cache_key = filepath.generic_string();
+  if (auto cached = file_cache_get(cache_key)) {
+    send_content(res, cached, content_type, throttle);
+    return;
+  }
+
+  auto file = handle ? std::make_shared<MappedFile>(std::move(handle))
+                     : std::make_shared<MappedFile>(filepath.string());
+  if (!file->is_open()) {
+    res.status = 500;
+    res.set_content("{\"error\":\"Failed to open file\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
+
+  // 小文件整体读入内存，并尝试放入热点缓存；
+  // 并发请求同一个未缓存的文件时只读取一次磁盘，其他请求等待并共享读取结果
+  if (file->size() <= FILE_CACHE_MAX_ENTRY_SIZE) {
+    static SingleFlight<std::shared_ptr<const std::string>> cache_fills;
+    // 按版本号区分，文件失效之后到达的请求不会共享失效前开始的读取
+    auto content = cache_fills.run(
+        cache_key + "#" + std::to_string(generation),
+        [&]() -> std::shared_ptr<const std::string> {
+          // 用 pread 复制而不是从映射页复制：文件在读取期间被截断时
+          // 只会得到较短的数据，不会因访问映射页触发 SIGBUS
+          auto data = std::make_shared<std::string>(file->size(), '\0');
+          if (file->copy(0, &(*data)[0], data->size()) != data->size()) {
+            return nullptr;
+          }
+          file_cache_put(cache_key, owner, generation, data);
+          return data;
+        });
+    if (!content) {
+      res.status = 500;
+      res.set_content("{\"error\":\"Failed to read file\"}",
+                      "application/json; charset=utf-8");
+      return;
+    }
+    send_content(res, content, content_type, throttle);
+    return;
+  }
+
+  res.set_header("Accept-Ranges", "bytes");
+  res.set_content_provider(
+      file->size(), content_type,
+      [file, throttle, readahead](size_t offset, size_t length,
+                                  httplib::DataSink &sink) {
+        size_t from, prefetch_length;
+        if (readahead && readahead->next(offset, from, prefetch_length)) {
+          file->prefetch(from, prefetch_length);
+        }
+        return file->read(offset, length, [&](const char *data, size_t len) {
+          return write_throttled(sink, throttle.get(), data, len);
+        });
+      });
+}
+
+// gzip 压缩存储文件的解压读取状态
+struct InflateState {
+  std::ifstream file;
+  std::unique_ptr<GzipInflater> inflater;
+  size_t pos = 0; // 已解压的原始数据字节数
+  std::vector<char> buffer;
+};
+
+// 以原始内容发送 gzip 压缩存储的文件，边读边解压（支持 Range）
+static void send_inflated_file(httplib::Response &res,
+                               const std::filesystem::path &filepath,
+                               size_t original_size,
+                               const std::string &content_type,
+                               std::shared_ptr<Throttle> throttle) {
+  auto state = std::make_shared<InflateState>();
+  state->file.open(filepath, std::ios::binary);
+  if (!state->file.is_open()) {
+    res.status = 500;
+    res.set_content("{\"error\":\"Failed to open file\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
+  state->inflater = std::make_unique<GzipInflater>();
+  state->buffer.resize(64 * 1024);
+
+  res.set_header("Accept-Ranges", "bytes");
+  res.set_content_provider(
+      original_size, content_type,
+      [state, throttle](size_t offset, size_t length,
+                        httplib::DataSink &sink) {
+        // 请求的位置在已解压位置之前（如多段 Range），从头重新解压
+        if (offset < state->pos) {
+          state->file.clear();
+          state->file.seekg(0);
+          state->inflater = std::make_unique<GzipInflater>();
+          state->pos = 0;
+        }
+
+        state->file.read(state->buffer.data(), state->buffer.size());
+        size_t n = static_cast<size_t>(state->file.gcount());
+        if (n == 0 || state->inflater->finished()) {
+          return false; // 数据比元数据记录的短
+        }
+
+        // 只输出落在 [offset, offset + length) 内的解压数据
+        size_t end = offset + length;
+        return state->inflater->inflate(
+            state->buffer.data(), n, [&](const char *data, size_t len) {
+              size_t begin = state->pos;
+              state->pos += len;
+              if (state->pos <= offset || begin >= end) {
+                return true;
+              }
+              size_t from = (std::max)(offset, begin) - begin;
+              size_t to = (std::min)(end, state->pos) - begin;
+              return write_throttled(sink, throttle.get(), data + from,
+                                     to - from);
+            });
+      });
+}
+
+// 查找预压缩变体（coding 为 "br" 或 "gzip"），尚未生成时交给后台生成，
+// 本次请求返回 false 并由调用方发送其他编码；
+// 超过 MAX_PRECOMPRESS_SIZE 的文件不生成变体
+static bool find_encoded_variant(const std::filesystem::path &filepath,
+                                 const std::string &filename,
+                                 const std::string &stored_encoding,
+                                 size_t original_size,
+                                 const std::string &coding,
+                                 std::filesystem::path &variant_path) {
+  std::string variant = coding == "br" ? "content.br" : "content.gz";
+  if (find_variant(filename, variant, variant_path)) {
+    return true;
+  }
+  if (original_size > MAX_PRECOMPRESS_SIZE) {
+    return false;
+  }
+
+  // 分块读取原文件（gzip 压缩存储的先解压）并流式压缩，
+  // 内存占用只有固定大小的缓冲区
+  create_variant_async(
+      filename, variant,
+      [filepath, stored_encoding, original_size,
+       coding](const VariantWriter &write) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file.is_open()) {
+          return false;
+        }
+        StreamCompressor compressor(coding, original_size);
+        auto compress = [&compressor, &write](const char *data, size_t len) {
+          return compressor.compress(data, len, write);
+        };
+
+        bool gzip = stored_encoding == "gzip";
+        GzipInflater inflater;
+        std::vector<char> buffer(64 * 1024);
+        while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+          size_t n = static_cast<size_t>(file.gcount());
+          if (!(gzip ? inflater.inflate(buffer.data(), n, compress)
+                     : compress(buffer.data(), n))) {
+            return false;
+          }
+        }
+        if (gzip && !inflater.finished()) {
+          return false;
+        }
+        return compressor.finish(write);
+      });
+  return false;
+}
+
+// 以 gzip 流式压缩写入文件，只使用压缩器内部固定大小的缓冲区；
+// 压缩结果达到 limit 字节时停止并返回 false，由调用方改为保存原始内容
+static bool write_gzip(std::ofstream &ofs, const std::string &content,
+                       size_t limit) {
+  StreamCompressor compressor("gzip", content.size());
+  size_t written = 0;
+  auto write = [&ofs, &written, limit](const char *data, size_t len) {
+    written += len;
+    if (written >= limit) {
+      return false;
+    }
+    ofs.write(data, static_cast<std::streamsize>(len));
+    return static_cast<bool>(ofs);
+  };
+  return compressor.compress(content.data(), content.size(), write) &&
+         compressor.finish(write);
+}
+
+// 转换为十六进制字符串
+static std::string to_hex(uint64_t value) {
+  std::stringstream ss;
+  ss << std::hex << value;
+  return ss.str();
+}
+
+// 格式化为 HTTP 日期（如 "Sun, 06 Nov 1994 08:49:37 GMT"）
+static std::string format_http_date(time_t t) {
+  struct tm tm_utc;
+#ifdef _WIN32
+  gmtime_s(&tm_utc, &t);
+#else
+  gmtime_r(&t, &tm_utc);
+#endif
+  char buf[64];
+  std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+  return buf;
+}
+
+// 解析 HTTP 日期，失败返回 -1
+static time_t parse_http_date(const std::string &value) {
+  static const char *months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+  char month_name[4] = {0};
+  int day, year, hour, minute, second;
+  if (std::sscanf(value.c_str(), "%*3s, %d %3s %d %d:%d:%d GMT", &day,
+                  month_name, &year, &hour, &minute, &second) != 6) {
+    return -1;
+  }
+  int month = 0;
+  while (month < 12 && std::strcmp(months[month], month_name) != 0) {
+    month++;
+  }
+  if (month == 12) {
+    return -1;
+  }
+
+  // 公历日期转换为距 1970-01-01 的天数
+  int y = year - (month < 2);
+  int era = (y >= 0 ? y : y - 399) / 400;
+  int yoe = y - era * 400;
+  int mp = (month + 10) % 12;
+  int doy = (153 * mp + 2) / 5 + day - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  long long days = static_cast<long long>(era) * 146097 + doe - 719468;
+  return static_cast<time_t>(days * 86400 + hour * 3600 + minute * 60 + second);
+}
+
+// 判断条件请求是否命中（If-None-Match 优先于 If-Modified-Since）
+static bool is_not_modified(const httplib::Request &req,
+                            const std::string &etag, time_t mtime) {
+  if (req.has_header("If-None-Match")) {
+    std::string value = req.get_header_value("If-None-Match");
+    size_t pos = 0;
+    while (pos < value.size()) {
+      size_t end = value.find(',', pos);
+      if (end == std::string::npos) {
+        end = value.size();
+      }
+      std::string tag = value.substr(pos, end - pos);
+      pos = end + 1;
+
+      tag.erase(0, tag.find_first_not_of(" \t"));
+      tag.erase(tag.find_last_not_of(" \t") + 1);
+      if (tag.rfind("W/", 0) == 0) {
+        tag.erase(0, 2); // If-None-Match 使用弱比较
+      }
+      if (tag == "*" || tag == etag) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (req.has_header("If-Modified-Since")) {
+    time_t since = parse_http_date(req.get_header_value("If-Modified-Since"));
+    return since != -1 && mtime <= since;
+  }
+  return false;
+}
+
+// 判断元数据是否描述磁盘上当前的文件：上传时记录了落盘后的大小和修改时间，
+// 文件被外部替换后至少有一项不同；没有记录（旧元数据）时视为不符
+static bool is_current_metadata(const json &metadata,
+                                const FileHandle &handle) {
+  return metadata.contains("storedSize") && metadata.contains("mtime") &&
+         metadata["storedSize"] == static_cast<uint64_t>(handle.size) &&
+         metadata["mtime"] == static_cast<int64_t>(handle.mtime);
+}
+
+// 使某个文件相关的所有缓存失效（句柄、热点内容、派生变体）
+void invalidate_cached_file(const std::string &filename) {
+  invalidate_file_handle(filename);
+  file_cache_invalidate(filename);
+  remove_variants(filename);
+}
+
 // 处理 /api/file-upload 请求（文件上传）
 void handle_file_upload(const httplib::Request &req, httplib::Response &res) {
   try {
@@ -204,17 +506,107 @@ void handle_file_upload(const httplib::Request &req, httplib::Response &res) {
       return;
     }
 
-    ofs.write(file.content.data(), file.content.size());
+    // 上传时确定一次类型并记录在元数据中，下载时不再判断：
+    // 优先按文件开头的魔数识别，避免扩展名与内容不符的文件被错误标记
+    const MimeInfo &mime =
+        detect_mime(file.content, filepath.extension().string());
+
+    json attributes = json::object();
+    attributes["mime"] = mime.content_type;
+    attributes["type"] = mime.file_type;
+
+    // 按顺序写入磁盘的数据片段，默认为原始内容
+    std::vector<std::string_view> pieces = {file.content};
+
+    // 图片只解析文件头取得宽高，前端无需加载图片即可布局
+    int image_width, image_height;
+    if (std::string(mime.file_type) == "image" &&
+        read_image_size(file.content, image_width, image_height)) {
+      attributes["width"] = image_width;
+      attributes["height"] = image_height;
+    }
+
+    // MP4 只解析盒结构记录时长、分辨率和编码；moov 位于文件末尾时
+    // 在写入的同时把它移到 mdat 之前（fast-start），浏览器无需先取得
+    // 文件尾部即可开始播放。调整在落盘前完成，保存的内容与摘要一致，
+    // 不会出现同一 hash 对应两种字节的情况
+    std::string faststart_moov;
+    Mp4Info mp4;
+    if (std::string(mime.file_type) == "video" &&
+        parse_mp4(file.content, mp4)) {
+      attributes["duration"] = std::round(mp4.duration * 1000) / 1000;
+      if (mp4.width > 0 && mp4.height > 0) {
+        attributes["width"] = mp4.width;
+        attributes["height"] = mp4.height;
+      }
+      if (!mp4.video_codec.empty()) {
+        attributes["videoCodec"] = mp4.video_codec;
+      }
+      if (!mp4.audio_codec.empty()) {
+        attributes["audioCodec"] = mp4.audio_codec;
+      }
+      if (plan_mp4_faststart(file.content, faststart_moov, pieces)) {
+        attributes["faststart"] = true;
+      }
+    }
+
+    // 保存内容的摘要，用作 ETag
+    Sha256 sha;
+    for (std::string_view piece : pieces) {
+      sha.update(piece.data(), piece.size());
+    }
+    std::string content_hash = sha.hex_digest();
+    attributes["hash"] = content_hash;
+
+    // 可压缩的文本类文件（JSON、SVG、CSS、JS 等）以 gzip 压缩存储，
+    // 边压缩边写入，不在内存中保留压缩结果；压缩收益不足 10% 时
+    // 清空已写入的数据，改为保存原始内容
+    bool compressed = false;
+    if (file.content.size() >= MIN_COMPRESS_SIZE &&
+        is_compressible_type(mime.content_type)) {
+      compressed =
+          write_gzip(ofs, file.content, file.content.size() / 10 * 9);
+      if (compressed) {
+        attributes["encoding"] = "gzip";
+      } else {
+        ofs.close();
+        ofs.open(filepath, std::ios::binary | std::ios::trunc);
+      }
+    }
+    if (!compressed) {
+      for (std::string_view piece : pieces) {
+        ofs.write(piece.data(), piece.size());
+      }
+    }
     ofs.close();
+    invalidate_cached_file(filename);
+
+    // 记录落盘后的大小和修改时间，下载时据此判断文件是否已被外部替换
+    if (auto written = acquire_file_handle(filename)) {
+      attributes["storedSize"] = written->size;
+      attributes["mtime"] = static_cast<int64_t>(written->mtime);
+    }
 
     // 保存文件元数据
     std::string timestamp = get_current_timestamp();
     std::string delete_code = generate_delete_code();
     if (!save_file_metadata(filename, file.content.size(), timestamp,
-                            delete_code)) {
+                            delete_code, attributes)) {
       std::cerr << "Warning: Failed to save file metadata for " << filename
                 << std::endl;
     }
+    file_index_add(filename, delete_code);
+    publish_event("file-uploaded", {{"filename", filename},
+                                    {"size", file.content.size()},
+                                    {"uploadTime", timestamp},
+                                    {"type", mime.file_type}});
+
+    // 压缩存储的文件在后台预生成 brotli 变体
+    if (compressed) {
+      std::filesystem::path variant_path;
+      find_encoded_variant(filepath, filename, "gzip", file.content.size(),
+                           "br", variant_path);
+    }
 
     // 返回成功响应（使用 nlohmann/json）
     json response = {{"success", true},
@@ -222,7 +614,8 @@ void handle_file_upload(const httplib::Request &req, httplib::Response &res) {
                      {"size", file.content.size()},
                      {"uploadTime", timestamp},
                      {"code", delete_code},
-                     {"path", "/api/file-get?name=" + filename}};
+                     {"path", "/api/file-get?name=" + filename},
+                     {"immutablePath", "/api/file-get?hash=" + content_hash}};
 
     res.set_content(response.dump(), "application/json; charset=utf-8");
   } catch (const std::exception &e) {
@@ -244,6 +637,29 @@ void handle_file_upload(const httplib::Request &req, httplib::Response &res) {
 void handle_file_get(const httplib::Request &req, httplib::Response &res) {
   // 获取查询参数 name
   std::string filename = req.get_param_value("name");
+
+  // 按内容摘要寻址的不可变 URL（?hash=<sha256>），解析为对应的文件名
+  bool immutable = false;
+  if (filename.empty() && req.has_param("hash")) {
+    std::string hash = req.get_param_value("hash");
+    json item;
+    if (hash.size() != 64 ||
+        hash.find_first_not_of("0123456789abcdef") != std::string::npos) {
+      res.status = 400;
+      res.set_content("{\"error\":\"Invalid parameter 'hash'\"}",
+                      "application/json; charset=utf-8");
+      return;
+    }
+    if (!find_file_metadata_by_hash(hash, item)) {
+      res.status = 404;
+      res.set_content("{\"error\":\"File not found\"}",
+                      "application/json; charset=utf-8");
+      return;
+    }
+    filename = item.value("filename", "");
+    immutable = true;
+  }
+
   if (filename.empty()) {
     res.status = 400;
     res.set_content("{\"error\":\"Missing parameter 'name'\"}",
@@ -262,31 +678,360 @@ void handle_file_get(const httplib::Request &req, httplib::Response &res) {
   // 构建文件路径
   std::filesystem::path filepath = std::filesystem::path("assets") / filename;
 
-  // 检查文件是否存在
-  if (!std::filesystem::exists(filepath) ||
-      !std::filesystem::is_regular_file(filepath)) {
+  // 检查文件是否存在：索引中一定不存在的文件名直接返回 404，不访问磁盘；
+  // 热点文件的句柄、大小和修改时间直接取自句柄缓存
+  // 缓存版本号在打开文件之前取得，之后的删除、重新上传都会使其过期
+  uint64_t generation = file_cache_generation(filename);
+  std::shared_ptr<const FileHandle> handle;
+  if (!file_may_exist(filename) ||
+      !(handle = acquire_file_handle(filename))) {
     res.status = 404;
     res.set_content("{\"error\":\"File not found\"}",
                     "application/json; charset=utf-8");
     return;
   }
 
-  // 读取文件内容
-  std::ifstream file(filepath, std::ios::binary);
-  if (!file.is_open()) {
-    res.status = 500;
-    res.set_content("{\"error\":\"Failed to open file\"}",
+  // 查找元数据（类型、存储编码、原始大小、内容摘要）；文件在上传之后被外部
+  // 替换时元数据描述的是旧内容（摘要、gzip 存储编码等都不再成立），整体忽略，
+  // 按扩展名判断类型，以 大小+修改时间 作为验证器
+  json metadata;
+  bool current = find_file_metadata(filename, metadata) &&
+                 is_current_metadata(metadata, *handle);
+  if (!current) {
+    metadata = json::object();
+  }
+  std::string content_type = metadata.value("mime", "");
+  std::string file_type = metadata.value("type", "");
+  std::string stored_encoding = metadata.value("encoding", "");
+  std::string content_hash = metadata.value("hash", "");
+  size_t original_size = metadata.value("size", handle->size);
+
+  // 按摘要寻址的 URL 承诺内容永不改变（immutable），文件已被替换时
+  // 磁盘上的内容不再是该摘要对应的内容，不能以此 URL 发送
+  if (immutable && !current) {
+    res.status = 404;
+    res.set_content("{\"error\":\"File not found\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
+
+  // 上传时已记录类型；没有记录（旧元数据或直接放入的文件）时按扩展名判断
+  if (content_type.empty() || file_type.empty()) {
+    const MimeInfo &mime = lookup_mime(filepath.extension().string());
+    content_type = mime.content_type;
+    file_type = mime.file_type;
+  }
+
+  // 当前表示的标识，附加在 ETag 之后区分缩放变体和不同编码
+  std::string representation;
+
+  // 图片按需缩放（?w=320），返回缓存的缩放变体
+  if (req.has_param("w") && file_type == "image") {
+    int width = parse_resize_width(req.get_param_value("w"));
+    if (width == 0) {
+      res.status = 400;
+      res.set_content("{\"error\":\"Invalid parameter 'w'\"}",
+                      "application/json; charset=utf-8");
+      return;
+    }
+
+    std::filesystem::path variant_path;
+    if (get_resized_variant(filepath, filename, metadata, width,
+                            variant_path)) {
+      filepath = variant_path;
+      content_type = "image/png";
+      representation = "-w" + std::to_string(width);
+    }
+  }
+
+  // 按 Accept-Encoding 协商内容编码：优先 br，其次 gzip，都不支持时发送原始内容
+  bool inflate = false;
+  if (stored_encoding == "gzip" || (is_compressible_type(content_type) &&
+                                    original_size >= MIN_COMPRESS_SIZE)) {
+    res.set_header("Vary", "Accept-Encoding");
+    std::string accept = req.get_header_value("Accept-Encoding");
+    std::filesystem::path variant_path;
+
+    if (accepts_encoding(accept, "br") &&
+        find_encoded_variant(filepath, filename, stored_encoding,
+                             original_size, "br", variant_path)) {
+      filepath = variant_path;
+      res.set_header("Content-Encoding", "br");
+      representation = "-br";
+    } else if (accepts_encoding(accept, "gzip") &&
+               (stored_encoding == "gzip" ||
+                find_encoded_variant(filepath, filename, stored_encoding,
+                                     original_size, "gzip", variant_path))) {
+      // gzip 压缩存储的文件直接发送存储的数据
+      if (stored_encoding != "gzip") {
+        filepath = variant_path;
+      }
+      res.set_header("Content-Encoding", "gzip");
+      representation = "-gz";
+    } else if (stored_encoding == "gzip") {
+      inflate = true;
+    }
+  }
+
+  // 缓存验证器：上传时记录的内容摘要，没有记录或文件已被替换时退化为
+  // 大小+修改时间
+  std::string validator =
+      content_hash.empty()
+          ? to_hex(static_cast<uint64_t>(handle->size)) + "-" +
+                to_hex(static_cast<uint64_t>(handle->mtime))
+          : content_hash.substr(0, 32);
+  std::string etag = "\"" + validator + representation + "\"";
+  res.set_header("ETag", etag);
+  res.set_header("Last-Modified", format_http_date(handle->mtime));
+  // 按摘要寻址的内容永远不会改变，可以被浏览器和 CDN 长期缓存；
+  // 按文件名访问的内容可能变化，每次使用前都需要验证
+  res.set_header("Cache-Control", immutable
+                                      ? "public, max-age=31536000, immutable"
+                                      : "public, no-cache");
+
+  if (is_not_modified(req, etag, handle->mtime)) {
+    res.status = 304;
+    return;
+  }
+
+  // 按原文件的类型限速（如视频限速、图片不限速）；限速下载在传输期间
+  // 一直占用工作线程，计入与 SSE 连接共享的名额，名额已满时返回 503
+  auto throttle = make_throttle(file_type);
+  if (throttle && !throttle->admit()) {
+    res.status = 503;
+    res.set_header("Retry-After", "1");
+    res.set_content("{\"error\":\"Too many throttled downloads\"}",
                     "application/json; charset=utf-8");
     return;
   }
 
-  std::string content((std::istreambuf_iterator<char>(file)),
-                      std::istreambuf_iterator<char>());
-  file.close();
+  if (inflate) {
+    send_inflated_file(res, filepath, original_size, content_type, throttle);
+  } else {
+    // 未替换为变体时直接复用已打开的句柄
+    bool is_source = filepath.string() == handle->path;
+
+    // 大文件的单段 Range 请求（视频播放、拖动）按 客户端+文件 跟踪访问位置，
+    // 顺序播放时逐步扩大预读窗口，提前把后续数据读入页缓存
+    std::shared_ptr<Readahead> readahead;
+    if (is_source && handle->size > FILE_CACHE_MAX_ENTRY_SIZE &&
+        req.ranges.size() == 1 && req.ranges[0].first >= 0) {
+      readahead = std::make_shared<Readahead>(
+          req.remote_addr + "|" + filename,
+          static_cast<size_t>(req.ranges[0].first), handle->size);
+    }
 
-  // 根据文件扩展名设置 Content-Type
-  std::string content_type = get_content_type(filepath);
-  res.set_content(content, content_type);
+    send_file(res, filepath, content_type, filename, generation, throttle,
+              is_source ? handle : nullptr, readahead);
+  }
+}
+
+// 归档中的一个文件
+struct ArchiveEntry {
+  std::string filename;
+  std::shared_ptr<const FileHandle> handle;
+  std::string file_type; // 文件类型（image/video/other），用于限速
+  bool inflate = false;  // gzip 压缩存储，需要边读边解压
+  size_t size = 0;       // 原始内容大小
+};
+
+// 归档的发送状态：每次调用内容提供器只发送一段数据，缓冲区大小固定
+struct ArchiveState {
+  std::vector<ArchiveEntry> entries;
+  size_t index = 0;     // 正在发送的条目
+  bool started = false; // 当前条目的本地文件头是否已发送
+  size_t pos = 0;       // 当前条目已发送的原始数据字节数
+  ZipStream zip;
+  std::unique_ptr<MappedFile> file;
+  std::unique_ptr<InflateState> inflate;
+  std::vector<char> buffer; // 未压缩条目的读取缓冲区
+  std::shared_ptr<Throttle> throttle; // 按当前条目的文件类型限速
+  std::shared_ptr<WorkerLease> lease; // 含限速条目时整个归档占用的工作线程名额
+};
+
+// 发送归档中当前条目的下一段数据；
+// 文件在发送期间被截断或被改短时，以已发送的数据结束当前条目，
+// 数据描述符和中央目录记录实际发送的大小和 CRC，归档仍然有效
+static bool send_archive_data(ArchiveState &state, const ArchiveEntry &entry,
+                              httplib::DataSink &sink) {
+  auto write = [&](const char *data, size_t len) {
+    if (len > entry.size - state.pos) {
+      return false; // 数据比元数据记录的长
+    }
+    state.zip.update(data, len);
+    state.pos += len;
+    return write_throttled(sink, state.throttle.get(), data, len);
+  };
+
+  // 计算 CRC 需要在用户态读取数据，用 pread 读入缓冲区而不是访问映射页，
+  // 文件被截断时只会读到较少的数据，不会触发 SIGBUS
+  if (!entry.inflate) {
+    size_t n = state.file->copy(
+        state.pos, state.buffer.data(),
+        (std::min)(state.buffer.size(), entry.size - state.pos));
+    if (n == 0) {
+      state.pos = entry.size;
+      return true;
+    }
+    return write(state.buffer.data(), n);
+  }
+
+  auto &inflate = *state.inflate;
+  inflate.file.read(inflate.buffer.data(), inflate.buffer.size());
+  size_t n = static_cast<size_t>(inflate.file.gcount());
+  if (n == 0 || inflate.inflater->finished()) {
+    state.pos = entry.size;
+    return true;
+  }
+  return inflate.inflater->inflate(inflate.buffer.data(), n, write);
+}
+
+// 处理 /api/file-archive 请求（将多个文件打包为 zip 下载）
+void handle_file_archive(const httplib::Request &req, httplib::Response &res) {
+  // 获取查询参数 names（逗号分隔的文件名）
+  std::string names = req.get_param_value("names");
+  if (names.empty()) {
+    res.status = 400;
+    res.set_content("{\"error\":\"Missing parameter 'names'\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
+
+  auto state = std::make_shared<ArchiveState>();
+  state->buffer.resize(64 * 1024);
+  std::set<std::string> seen;
+  uint64_t archive_size = ZIP_END_RECORD_SIZE;
+  std::stringstream ss(names);
+  std::string filename;
+  while (std::getline(ss, filename, ',')) {
+    if (filename.empty() || !seen.insert(filename).second) {
+      continue; // 忽略空名称和重复的文件
+    }
+    if (!is_valid_filename(filename)) {
+      res.status = 400;
+      json error = {{"error", "Invalid filename"}, {"filename", filename}};
+      res.set_content(error.dump(), "application/json; charset=utf-8");
+      return;
+    }
+    if (seen.size() > MAX_ARCHIVE_FILES) {
+      res.status = 400;
+      json error = {{"error", "Too many files"},
+                    {"maxFiles", MAX_ARCHIVE_FILES}};
+      res.set_content(error.dump(), "application/json; charset=utf-8");
+      return;
+    }
+
+    ArchiveEntry entry;
+    entry.filename = filename;
+    if (!file_may_exist(filename) ||
+        !(entry.handle = acquire_file_handle(filename))) {
+      res.status = 404;
+      json error = {{"error", "File not found"}, {"filename", filename}};
+      res.set_content(error.dump(), "application/json; charset=utf-8");
+      return;
+    }
+    entry.size = entry.handle->size;
+
+    // 文件已被外部替换时忽略元数据，按磁盘上的内容原样打包
+    json metadata;
+    if (find_file_metadata(filename, metadata) &&
+        is_current_metadata(metadata, *entry.handle)) {
+      entry.file_type = metadata.value("type", "");
+      if (metadata.value("encoding", "") == "gzip") {
+        entry.inflate = true;
+        entry.size = metadata.value("size", entry.size);
+      }
+    }
+    if (entry.file_type.empty()) {
+      entry.file_type =
+          lookup_mime(std::filesystem::path(filename).extension().string())
+              .file_type;
+    }
+
+    archive_size += ZIP_ENTRY_OVERHEAD + 2 * filename.size() + entry.size;
+    state->entries.push_back(std::move(entry));
+  }
+
+  if (state->entries.empty()) {
+    res.status = 400;
+    res.set_content("{\"error\":\"Missing parameter 'names'\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
+
+  // 不支持 ZIP64，超过 4GB 的归档无法表示
+  if (archive_size > ZIP_MAX_ARCHIVE_SIZE) {
+    res.status = 413;
+    json error = {{"error", "Archive too large. Maximum size is 4GB."},
+                  {"maxSize", ZIP_MAX_ARCHIVE_SIZE},
+                  {"archiveSize", archive_size}};
+    res.set_content(error.dump(), "application/json; charset=utf-8");
+    return;
+  }
+
+  // 含限速条目的归档在发送期间会等待令牌，需要先申请工作线程名额
+  for (const auto &entry : state->entries) {
+    if (is_rate_limited(entry.file_type)) {
+      state->lease = acquire_worker_lease();
+      if (!state->lease) {
+        res.status = 503;
+        res.set_header("Retry-After", "1");
+        res.set_content("{\"error\":\"Too many throttled downloads\"}",
+                        "application/json; charset=utf-8");
+        return;
+      }
+      break;
+    }
+  }
+
+  res.set_header("Content-Disposition", "attachment; filename=\"files.zip\"");
+  res.set_chunked_content_provider(
+      "application/zip", [state](size_t, httplib::DataSink &sink) {
+        // 所有条目发送完毕，输出中央目录
+        if (state->index == state->entries.size()) {
+          std::string tail = state->zip.finish();
+          if (!sink.write(tail.data(), tail.size())) {
+            return false;
+          }
+          sink.done();
+          return true;
+        }
+
+        const auto &entry = state->entries[state->index];
+
+        // 打开文件并发送本地文件头
+        if (!state->started) {
+          if (entry.inflate) {
+            state->inflate = std::make_unique<InflateState>();
+            state->inflate->file.open(entry.handle->path, std::ios::binary);
+            if (!state->inflate->file.is_open()) {
+              return false;
+            }
+            state->inflate->inflater = std::make_unique<GzipInflater>();
+            state->inflate->buffer.resize(64 * 1024);
+          } else {
+            state->file = std::make_unique<MappedFile>(entry.handle);
+          }
+          state->throttle = make_throttle(entry.file_type);
+          state->started = true;
+          state->pos = 0;
+          std::string header =
+              state->zip.begin_entry(entry.filename, entry.handle->mtime);
+          return sink.write(header.data(), header.size());
+        }
+
+        if (state->pos < entry.size) {
+          return send_archive_data(*state, entry, sink);
+        }
+
+        // 当前条目结束，发送数据描述符并关闭文件
+        state->file.reset();
+        state->inflate.reset();
+        state->started = false;
+        ++state->index;
+        std::string descriptor = state->zip.end_entry();
+        return sink.write(descriptor.data(), descriptor.size());
+      });
 }
 
 // 处理 /api/file-list 请求（获取所有上传文件的信息）
@@ -331,6 +1076,9 @@ void handle_file_delete_by_code(const httplib::Request &req,
   // 删除文件
   std::string deleted_filename;
   if (delete_file_by_code(delete_code, deleted_filename)) {
+    invalidate_cached_file(deleted_filename);
+    file_index_note_removed();
+    publish_event("file-deleted", {{"filename", deleted_filename}});
     json response = {{"success", true}, {"filename", deleted_filename}};
     res.set_content(response.dump(), "application/json; charset=utf-8");
   } else {
@@ -340,6 +1088,39 @@ void handle_file_delete_by_code(const httplib::Request &req,
   }
 }
 
+// 根据元数据条目构建预览信息：大小和类型取自上传时记录的元数据
+// （旧元数据中没有记录类型时按扩展名判断）
+static json build_preview(const json &item) {
+  std::string filename = item["filename"].get<std::string>();
+  std::string file_type = item.value("type", "");
+  if (file_type.empty()) {
+    file_type =
+        lookup_mime(std::filesystem::path(filename).extension().string())
+            .file_type;
+  }
+  size_t file_size = item.value("size", static_cast<size_t>(0));
+
+  json preview = {
+      {"filename", filename}, {"type", file_type}, {"size", file_size}};
+
+  // 上传时记录的图片、视频宽高和视频时长
+  if (item.contains("width") && item.contains("height")) {
+    preview["width"] = item["width"];
+    preview["height"] = item["height"];
+  }
+  if (item.contains("duration")) {
+    preview["duration"] = item["duration"];
+  }
+
+  // 根据类型决定是否提供预览 URL
+  if (file_type == "image" || file_type == "video") {
+    preview["url"] = "/api/file-get?name=" + filename;
+  } else {
+    preview["url"] = "";
+  }
+  return preview;
+}
+
 // 处理 /api/file-preview 请求（获取文件预览信息）
 void handle_file_preview(const httplib::Request &req, httplib::Response &res) {
   // 获取查询参数 code
@@ -359,73 +1140,72 @@ void handle_file_preview(const httplib::Request &req, httplib::Response &res) {
     return;
   }
 
-  // 从元数据中查找对应的文件
-  std::ifstream ifs("meta/file_metadata.json");
-  if (!ifs.is_open()) {
+  // 索引中一定不存在的删除码直接返回 404，不读取元数据
+  if (!code_may_exist(code)) {
     res.status = 404;
-    json error = {{"error", "Metadata not found"}};
+    json error = {{"error", "File not found or code invalid"}};
     res.set_content(error.dump(), "application/json; charset=utf-8");
     return;
   }
 
-  json metadata_array;
-  try {
-    ifs >> metadata_array;
-    ifs.close();
-  } catch (const json::exception &e) {
-    ifs.close();
-    res.status = 500;
-    json error = {{"error", "Failed to parse metadata"}};
+  // 从内存中的元数据索引查找对应的文件，不读取元数据文件，也不访问文件本身
+  json item;
+  if (!find_file_metadata_by_code(code, item) || !item.contains("filename")) {
+    res.status = 404;
+    json error = {{"error", "File not found or code invalid"}};
     res.set_content(error.dump(), "application/json; charset=utf-8");
     return;
   }
 
-  // 查找匹配的文件
-  std::string filename;
-  bool found = false;
-
-  for (const auto &item : metadata_array) {
-    if (item.contains("code") && item["code"] == code) {
-      if (item.contains("filename")) {
-        filename = item["filename"].get<std::string>();
-        found = true;
-        break;
-      }
-    }
-  }
+  json response = build_preview(item);
+  res.set_content(response.dump(2), "application/json; charset=utf-8");
+}
 
-  if (!found) {
-    res.status = 404;
-    json error = {{"error", "File not found or code invalid"}};
+// 处理 /api/file-preview/batch 请求（批量获取文件预览信息）
+void handle_file_preview_batch(const httplib::Request &req,
+                               httplib::Response &res) {
+  // 请求体：{"codes": ["a8K9xP2m", ...]}
+  json body = json::parse(req.body, nullptr, false);
+  if (body.is_discarded() || !body.is_object() || !body.contains("codes") ||
+      !body["codes"].is_array()) {
+    res.status = 400;
+    json error = {{"error", "Request body must be {\"codes\": [...]}"}};
     res.set_content(error.dump(), "application/json; charset=utf-8");
     return;
   }
 
-  // 构建文件路径并检查是否存在
-  std::filesystem::path filepath = std::filesystem::path("assets") / filename;
-  if (!std::filesystem::exists(filepath) ||
-      !std::filesystem::is_regular_file(filepath)) {
-    res.status = 404;
-    json error = {{"error", "File not found on disk"}};
+  const json &codes_json = body["codes"];
+  if (codes_json.size() > MAX_PREVIEW_BATCH) {
+    res.status = 400;
+    json error = {{"error", "Too many codes"},
+                  {"maxCodes", MAX_PREVIEW_BATCH}};
     res.set_content(error.dump(), "application/json; charset=utf-8");
     return;
   }
 
-  // 获取文件信息
-  std::string ext = filepath.extension().string();
-  std::string file_type = get_file_type(ext);
-  size_t file_size = std::filesystem::file_size(filepath);
+  std::vector<std::string> codes;
+  codes.reserve(codes_json.size());
+  for (const auto &code : codes_json) {
+    codes.push_back(code.is_string() ? code.get<std::string>() : "");
+  }
 
-  // 构建响应
-  json response = {
-      {"filename", filename}, {"type", file_type}, {"size", file_size}};
+  // 一次加锁完成所有查找
+  std::vector<json> items;
+  find_file_metadata_by_codes(codes, items);
 
-  // 根据类型决定是否提供预览 URL
-  if (file_type == "image" || file_type == "video") {
-    response["url"] = "/api/file-get?name=" + filename;
-  } else {
-    response["url"] = "";
+  // 按请求顺序返回，找不到的删除码返回错误信息
+  json data = json::array();
+  for (size_t i = 0; i < codes.size(); ++i) {
+    if (items[i].is_object() && items[i].contains("filename")) {
+      json preview = build_preview(items[i]);
+      preview["code"] = codes[i];
+      data.push_back(preview);
+    } else {
+      data.push_back(
+          {{"code", codes[i]}, {"error", "File not found or code invalid"}});
+    }
   }
 
-  res.set_content(response.dump(2), "application/json; charset=utf-8");
+  json response = {{"success", true}, {"data", data}};
+  res.set_content(response.dump(), "application/json; charset=utf-8");
 }
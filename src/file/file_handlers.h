@@ -5,15 +5,23 @@
 
 // 配置常量
 #define MAX_FILE_SIZE (2LL * 1024 * 1024 * 1024) // 2GB 文件大小限制
+#define MAX_ARCHIVE_FILES 100 // 一次打包下载的最大文件数
+#define MAX_PREVIEW_BATCH 100 // 一次批量预览的最大删除码数
 
 // 文件操作处理函数
 
+// 使某个文件相关的所有缓存失效（句柄、热点内容、派生变体）
+void invalidate_cached_file(const std::string &filename);
+
 // 处理 /api/file-upload 请求（文件上传）
 void handle_file_upload(const httplib::Request &req, httplib::Response &res);
 
 // 处理 /api/file-get 请求（文件下载）
 void handle_file_get(const httplib::Request &req, httplib::Response &res);
 
+// 处理 /api/file-archive 请求（将多个文件打包为 zip 下载）
+void handle_file_archive(const httplib::Request &req, httplib::Response &res);
+
 // 处理 /api/file-list 请求（获取所有上传文件的信息）
 void handle_file_list(const httplib::Request &req, httplib::Response &res);
 
@@ -24,4 +32,8 @@ void handle_file_delete_by_code(const httplib::Request &req,
 // 处理 /api/file-preview 请求（获取文件预览信息）
 void handle_file_preview(const httplib::Request &req, httplib::Response &res);
 
+// 处理 /api/file-preview/batch 请求（批量获取文件预览信息）
+void handle_file_preview_batch(const httplib::Request &req,
+                               httplib::Response &res);
+
 #endif // FILE_HANDLERS_H
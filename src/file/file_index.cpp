@@ -0,0 +1,165 @@
+#include "file_index.h"
+#include "file_manager.h"
+#include <algorithm>
+#include <filesystem>
+#include <json.hpp>
+#include <memory>
+#include <mutex>
+
+using json = nlohmann::json;
+
+// 计算两个相互独立的 64 位哈希值（FNV-1a 及其混淆），用于双重哈希
+static void hash_key(const std::string &key, uint64_t &h1, uint64_t &h2) {
+  uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  h1 = h;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  h2 = h | 1;
+}
+
+BloomFilter::BloomFilter(size_t capacity) {
+  num_bits_ = (std::max)(capacity, static_cast<size_t>(1)) *
+              FILE_INDEX_BITS_PER_ITEM;
+  bits_.assign((num_bits_ + 63) / 64, 0);
+}
+
+void BloomFilter::add(const std::string &key) {
+  uint64_t h1, h2;
+  hash_key(key, h1, h2);
+  for (int i = 0; i < FILE_INDEX_HASH_COUNT; ++i) {
+    size_t bit = static_cast<size_t>((h1 + i * h2) % num_bits_);
+    bits_[bit / 64] |= 1ULL << (bit % 64);
+  }
+}
+
+bool BloomFilter::might_contain(const std::string &key) const {
+  uint64_t h1, h2;
+  hash_key(key, h1, h2);
+  for (int i = 0; i < FILE_INDEX_HASH_COUNT; ++i) {
+    size_t bit = static_cast<size_t>((h1 + i * h2) % num_bits_);
+    if (!(bits_[bit / 64] & (1ULL << (bit % 64)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+std::mutex index_mutex;
+bool initialized = false;
+bool names_tracked = false;
+size_t capacity = FILE_INDEX_INITIAL_CAPACITY;
+size_t added = 0;   // 当前过滤器中加入的元素个数
+size_t removed = 0; // 上次重建后的删除次数
+std::unique_ptr<BloomFilter> names;
+std::unique_ptr<BloomFilter> codes;
+
+// 从元数据和 assets 目录重建过滤器（需持有锁）
+// 调用方保证先写入文件和元数据再调用 file_index_add，
+// 因此重建期间新增的文件要么被这里扫描到，要么随后由 file_index_add 加入
+void rebuild_locked() {
+  json metadata = json::parse(read_file_metadata(), nullptr, false);
+  std::vector<std::string> filenames;
+  std::vector<std::string> delete_codes;
+  if (metadata.is_array()) {
+    for (const auto &item : metadata) {
+      if (item.contains("filename") && item["filename"].is_string()) {
+        filenames.push_back(item["filename"].get<std::string>());
+      }
+      if (item.contains("code") && item["code"].is_string()) {
+        delete_codes.push_back(item["code"].get<std::string>());
+      }
+    }
+  }
+
+  // 没有元数据、直接放入 assets 目录的文件同样可以下载
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it("assets", ec), end;
+       !ec && it != end; it.increment(ec)) {
+    if (it->is_regular_file(ec)) {
+      filenames.push_back(it->path().filename().string());
+    }
+  }
+
+  size_t count = (std::max)(filenames.size(), delete_codes.size());
+  while (capacity < count * 2) {
+    capacity *= 2;
+  }
+  names = std::make_unique<BloomFilter>(capacity);
+  codes = std::make_unique<BloomFilter>(capacity);
+  for (const auto &filename : filenames) {
+    names->add(filename);
+  }
+  for (const auto &code : delete_codes) {
+    codes->add(code);
+  }
+  added = count;
+  removed = 0;
+}
+
+} // namespace
+
+// 初始化文件索引
+void init_file_index(bool track_names) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  names_tracked = track_names;
+  rebuild_locked();
+  initialized = true;
+}
+
+// 记录新增的文件名和删除码
+void file_index_add(const std::string &filename, const std::string &code) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  if (!initialized) {
+    return;
+  }
+  // 超出容量时误判率迅速上升，扩容重建
+  if (++added > capacity) {
+    capacity *= 2;
+    rebuild_locked();
+  }
+  names->add(filename);
+  if (!code.empty()) {
+    codes->add(code);
+  }
+}
+
+// 重新扫描并重建过滤器
+void file_index_rebuild() {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  if (initialized) {
+    rebuild_locked();
+  }
+}
+
+// 记录一次删除
+void file_index_note_removed() {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  if (!initialized) {
+    return;
+  }
+  // 已删除的元素超过四分之一时重建，避免误判率随删除不断升高
+  if (++removed > 64 && removed * 4 > added) {
+    rebuild_locked();
+  }
+}
+
+// 文件名可能存在时返回 true
+bool file_may_exist(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  return !initialized || !names_tracked || names->might_contain(filename);
+}
+
+// 删除码可能存在时返回 true
+bool code_may_exist(const std::string &code) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  return !initialized || codes->might_contain(code);
+}
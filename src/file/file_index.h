@@ -0,0 +1,48 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 过滤器初始容量（元素个数），超出后按两倍扩容重建
+#define FILE_INDEX_INITIAL_CAPACITY 4096
+// 每个元素占用的位数和哈希函数个数（误判率约 1%）
+#define FILE_INDEX_BITS_PER_ITEM 10
+#define FILE_INDEX_HASH_COUNT 7
+
+// 布隆过滤器：might_contain 返回 false 时元素一定不存在，
+// 返回 true 时元素可能存在（需要进一步确认）
+class BloomFilter {
+public:
+  explicit BloomFilter(size_t capacity);
+
+  void add(const std::string &key);
+  bool might_contain(const std::string &key) const;
+
+private:
+  std::vector<uint64_t> bits_;
+  size_t num_bits_;
+};
+
+// 初始化文件索引：从元数据和 assets 目录加载所有文件名和删除码；
+// track_names 为 false 时（无法感知 assets 目录的外部修改）不过滤文件名
+void init_file_index(bool track_names);
+
+// 记录新增的文件名和删除码（code 为空时只记录文件名）
+void file_index_add(const std::string &filename, const std::string &code = "");
+
+// 重新扫描元数据和 assets 目录重建过滤器（监听事件丢失时调用）
+void file_index_rebuild();
+
+// 记录一次删除：布隆过滤器无法移除元素，删除累计过多时重建
+void file_index_note_removed();
+
+// 文件名可能存在时返回 true，返回 false 时可以直接判定不存在
+bool file_may_exist(const std::string &filename);
+
+// 删除码可能存在时返回 true，返回 false 时可以直接判定不存在
+bool code_may_exist(const std::string &code);
+
+#endif // FILE_INDEX_H
@@ -1,13 +1,16 @@
 #include "file_manager.h"
 #include <chrono>
+#include <cstdint>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <json.hpp>
+#include <mutex>
 #include <random>
 #include <sstream>
+#include <unordered_map>
 
 using json = nlohmann::json;
 
@@ -38,135 +41,232 @@ std::string get_current_timestamp() {
   return ss.str();
 }
 
-// 保存文件元数据（使用 nlohmann/json）
-bool save_file_metadata(const std::string &filename, size_t size,
-                        const std::string &timestamp,
-                        const std::string &delete_code) {
-  // 确保 meta 目录存在
-  std::filesystem::path meta_dir("meta");
-  if (!std::filesystem::exists(meta_dir)) {
-    std::filesystem::create_directory(meta_dir);
+// 内存中的元数据副本：首次访问时从磁盘加载，之后所有读写都在内存中完成，
+// 修改时再整体写回磁盘
+static std::mutex metadata_mutex;
+static json metadata_cache;
+static bool metadata_loaded = false;
+static uint64_t metadata_version = 0; // 每次修改后递增
+
+// 写回磁盘在 metadata_mutex 之外进行，由单独的锁串行化，
+// 查找元数据的请求不需要等待磁盘写入
+static std::mutex write_mutex;
+static uint64_t written_version = 0; // 已写入磁盘的最新版本
+
+// 元数据索引：文件名 / 删除码 / 内容摘要 -> 条目在数组中的下标，
+// 查找时不再线性扫描；新增条目时追加索引，删除条目后整体重建
+static std::unordered_map<std::string, size_t> index_by_filename;
+static std::unordered_map<std::string, size_t> index_by_code;
+static std::unordered_map<std::string, size_t> index_by_hash;
+
+// 将第 pos 个条目加入索引（需持有锁），重复的值保留最早的条目
+static void index_entry_locked(size_t pos) {
+  const json &entry = metadata_cache[pos];
+  auto add = [&](std::unordered_map<std::string, size_t> &index,
+                 const char *field) {
+    if (entry.contains(field) && entry[field].is_string()) {
+      index.emplace(entry[field].get<std::string>(), pos);
+    }
+  };
+  add(index_by_filename, "filename");
+  add(index_by_code, "code");
+  add(index_by_hash, "hash");
+}
+
+// 重建全部索引（需持有锁）
+static void rebuild_index_locked() {
+  index_by_filename.clear();
+  index_by_code.clear();
+  index_by_hash.clear();
+  for (size_t i = 0; i < metadata_cache.size(); ++i) {
+    index_entry_locked(i);
   }
+}
 
-  json metadata_array;
+// 通过索引查找条目（需持有锁）
+static bool find_indexed_locked(
+    const std::unordered_map<std::string, size_t> &index,
+    const std::string &key, json &item) {
+  auto it = index.find(key);
+  if (it == index.end()) {
+    return false;
+  }
+  item = metadata_cache[it->second];
+  return true;
+}
+
+// 加载元数据到内存（需持有锁）
+static void load_metadata_locked() {
+  if (metadata_loaded) {
+    return;
+  }
+  metadata_loaded = true;
 
-  // 读取现有元数据
   std::ifstream ifs(METADATA_FILE);
   if (ifs.is_open()) {
     try {
-      ifs >> metadata_array;
+      ifs >> metadata_cache;
       ifs.close();
     } catch (const json::exception &e) {
       ifs.close();
-      metadata_array = json::array(); // 解析失败，创建新数组
+      metadata_cache = json::array(); // 解析失败，创建新数组
     }
   } else {
-    metadata_array = json::array(); // 文件不存在，创建新数组
+    metadata_cache = json::array(); // 文件不存在，创建新数组
   }
 
   // 如果不是数组，重新创建
-  if (!metadata_array.is_array()) {
-    metadata_array = json::array();
+  if (!metadata_cache.is_array()) {
+    metadata_cache = json::array();
   }
+  rebuild_index_locked();
+}
 
-  // 创建新的文件条目
-  json item = {{"filename", filename},
-               {"size", size},
-               {"uploadTime", timestamp},
-               {"code", delete_code}};
+// 序列化修改后的内存元数据（需持有锁），version 返回本次修改的版本号
+static std::string serialize_metadata_locked(uint64_t &version) {
+  version = ++metadata_version;
+  return metadata_cache.dump(2); // 格式化输出，缩进2个空格
+}
 
-  // 添加到数组
-  metadata_array.push_back(item);
+// 将序列化后的元数据写回文件（不持有 metadata_mutex）：先写入临时文件再重命名，
+// 不会留下写了一半的文件；并发修改时较旧的版本不会覆盖已写入的较新版本
+static bool write_metadata(const std::string &content, uint64_t version) {
+  std::lock_guard<std::mutex> lock(write_mutex);
+  if (version <= written_version) {
+    return true; // 包含本次修改的更新版本已经写入
+  }
 
-  // 写入文件
-  std::ofstream ofs(METADATA_FILE);
+  std::string tmp_path = METADATA_FILE ".tmp";
+  std::ofstream ofs(tmp_path, std::ios::trunc);
   if (!ofs.is_open()) {
     return false;
   }
-
-  ofs << metadata_array.dump(2); // 格式化输出，缩进2个空格
+  ofs << content;
   ofs.close();
-
-  return true;
-}
-
-// 根据删除码删除文件及其元数据（使用 nlohmann/json）
-bool delete_file_by_code(const std::string &delete_code,
-                         std::string &deleted_filename) {
-  // 读取元数据
-  std::ifstream ifs(METADATA_FILE);
-  if (!ifs.is_open()) {
+  if (!ofs) {
     return false;
   }
 
-  json metadata_array;
-  try {
-    ifs >> metadata_array;
-    ifs.close();
-  } catch (const json::exception &e) {
-    ifs.close();
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, METADATA_FILE, ec);
+  if (ec) {
     return false;
   }
+  written_version = version;
+  return true;
+}
 
-  if (!metadata_array.is_array()) {
-    return false;
+// 保存文件元数据（使用 nlohmann/json）
+bool save_file_metadata(const std::string &filename, size_t size,
+                        const std::string &timestamp,
+                        const std::string &delete_code,
+                        const json &attributes) {
+  // 确保 meta 目录存在
+  std::filesystem::path meta_dir("meta");
+  if (!std::filesystem::exists(meta_dir)) {
+    std::filesystem::create_directory(meta_dir);
   }
 
-  // 查找并删除匹配的条目
-  bool found = false;
-  for (auto it = metadata_array.begin(); it != metadata_array.end(); ++it) {
-    if (it->contains("code") && (*it)["code"] == delete_code) {
-      // 找到了，提取文件名
-      if (it->contains("filename")) {
-        deleted_filename = (*it)["filename"].get<std::string>();
-      }
+  // 创建新的文件条目
+  json item = {{"filename", filename},
+               {"size", size},
+               {"uploadTime", timestamp},
+               {"code", delete_code}};
+  item.update(attributes);
 
-      // 从数组中删除
-      metadata_array.erase(it);
-      found = true;
-      break;
-    }
-  }
+  std::string content;
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    load_metadata_locked();
 
-  if (!found) {
-    return false;
+    // 添加到数组
+    metadata_cache.push_back(std::move(item));
+    index_entry_locked(metadata_cache.size() - 1);
+    content = serialize_metadata_locked(version);
   }
 
-  // 删除实际文件
-  std::filesystem::path filepath =
-      std::filesystem::path("assets") / deleted_filename;
-  if (std::filesystem::exists(filepath)) {
-    try {
-      std::filesystem::remove(filepath);
-    } catch (const std::exception &e) {
-      std::cerr << "Failed to delete file: " << e.what() << std::endl;
+  // 写入文件
+  return write_metadata(content, version);
+}
+
+// 根据删除码删除文件及其元数据（使用 nlohmann/json）
+bool delete_file_by_code(const std::string &delete_code,
+                         std::string &deleted_filename) {
+  std::string content;
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    load_metadata_locked();
+
+    // 查找匹配的条目
+    auto found = index_by_code.find(delete_code);
+    if (found == index_by_code.end()) {
       return false;
     }
-  }
+    auto it = metadata_cache.begin() + found->second;
+    if (it->contains("filename")) {
+      deleted_filename = (*it)["filename"].get<std::string>();
+    }
 
-  // 更新元数据文件
-  std::ofstream ofs(METADATA_FILE);
-  if (!ofs.is_open()) {
-    return false;
-  }
+    // 删除实际文件
+    std::filesystem::path filepath =
+        std::filesystem::path("assets") / deleted_filename;
+    if (std::filesystem::exists(filepath)) {
+      try {
+        std::filesystem::remove(filepath);
+      } catch (const std::exception &e) {
+        std::cerr << "Failed to delete file: " << e.what() << std::endl;
+        return false;
+      }
+    }
 
-  ofs << metadata_array.dump(2); // 格式化输出
-  ofs.close();
+    // 从数组中删除
+    metadata_cache.erase(it);
+    rebuild_index_locked();
+    content = serialize_metadata_locked(version);
+  }
 
-  return true;
+  // 更新元数据文件
+  return write_metadata(content, version);
 }
 
 // 读取所有文件元数据
 std::string read_file_metadata() {
-  std::ifstream ifs(METADATA_FILE);
-  if (!ifs.is_open()) {
-    // 如果文件不存在，返回空数组
-    return "[]";
-  }
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  load_metadata_locked();
+  return metadata_cache.dump();
+}
+
+// 根据文件名查找元数据条目（从内存读取，不访问磁盘）
+bool find_file_metadata(const std::string &filename, json &item) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  load_metadata_locked();
+  return find_indexed_locked(index_by_filename, filename, item);
+}
 
-  std::stringstream buffer;
-  buffer << ifs.rdbuf();
-  ifs.close();
+// 根据删除码查找元数据条目（从内存读取，不访问磁盘）
+bool find_file_metadata_by_code(const std::string &code, json &item) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  load_metadata_locked();
+  return find_indexed_locked(index_by_code, code, item);
+}
+
+// 批量根据删除码查找元数据条目
+void find_file_metadata_by_codes(const std::vector<std::string> &codes,
+                                 std::vector<json> &items) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  load_metadata_locked();
+
+  items.assign(codes.size(), json());
+  for (size_t i = 0; i < codes.size(); ++i) {
+    find_indexed_locked(index_by_code, codes[i], items[i]);
+  }
+}
 
-  return buffer.str();
+// 根据内容摘要查找元数据条目（从内存读取，不访问磁盘）
+bool find_file_metadata_by_hash(const std::string &hash, json &item) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+  load_metadata_locked();
+  return find_indexed_locked(index_by_hash, hash, item);
 }
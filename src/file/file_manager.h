@@ -1,7 +1,9 @@
 #ifndef FILE_MANAGER_H
 #define FILE_MANAGER_H
 
+#include <json.hpp>
 #include <string>
+#include <vector>
 
 // 生成随机删除码（8位字母数字组合）
 std::string generate_delete_code();
@@ -9,10 +11,11 @@ std::string generate_delete_code();
 // 获取当前时间的 ISO 8601 格式字符串
 std::string get_current_timestamp();
 
-// 保存文件元数据
-bool save_file_metadata(const std::string &filename, size_t size,
-                        const std::string &timestamp,
-                        const std::string &delete_code);
+// 保存文件元数据（attributes 中的附加字段会合并到元数据条目中）
+bool save_file_metadata(
+    const std::string &filename, size_t size, const std::string &timestamp,
+    const std::string &delete_code,
+    const nlohmann::json &attributes = nlohmann::json::object());
 
 // 根据删除码删除文件及其元数据
 bool delete_file_by_code(const std::string &delete_code,
@@ -21,4 +24,18 @@ bool delete_file_by_code(const std::string &delete_code,
 // 读取所有文件元数据
 std::string read_file_metadata();
 
+// 根据文件名查找元数据条目（从内存读取，不访问磁盘）
+bool find_file_metadata(const std::string &filename, nlohmann::json &item);
+
+// 根据删除码查找元数据条目（从内存读取，不访问磁盘）
+bool find_file_metadata_by_code(const std::string &code, nlohmann::json &item);
+
+// 批量根据删除码查找元数据条目（一次加锁完成全部查找），
+// items 与 codes 一一对应，找不到的位置为 null
+void find_file_metadata_by_codes(const std::vector<std::string> &codes,
+                                 std::vector<nlohmann::json> &items);
+
+// 根据内容摘要查找元数据条目（从内存读取，不访问磁盘）
+bool find_file_metadata_by_hash(const std::string &hash, nlohmann::json &item);
+
 #endif // FILE_MANAGER_H
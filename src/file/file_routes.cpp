@@ -1,14 +1,28 @@
 #include "file_routes.h"
+#include "file_handle_cache.h"
 #include "file_handlers.h"
+#include "file_index.h"
 
 // 配置文件操作相关路由
 void configure_file_routes(httplib::Server &server) {
   // 设置文件上传大小限制
   server.set_payload_max_length(MAX_FILE_SIZE);
 
+  // assets 目录被外部修改时同步清理缓存并更新文件索引，事件丢失时重新扫描；
+  // 无法监听时文件索引不过滤文件名，避免外部放入的文件被误判为不存在
+  bool watching = watch_assets_changes(
+      [](const std::string &filename) {
+        file_index_add(filename);
+        invalidate_cached_file(filename);
+      },
+      [] { file_index_rebuild(); });
+  init_file_index(watching);
+
   server.Get("/api/file-get", handle_file_get);
+  server.Get("/api/file-archive", handle_file_archive);
   server.Get("/api/file-list", handle_file_list);
   server.Get("/api/file-preview", handle_file_preview);
+  server.Post("/api/file-preview/batch", handle_file_preview_batch);
   server.Post("/api/file-upload", handle_file_upload);
   server.Delete("/api/file-delete", handle_file_delete_by_code);
 }
@@ -0,0 +1,163 @@
+#include "image_info.h"
+#include <cstddef>
+#include <cstdint>
+
+static uint32_t byte_at(std::string_view data, size_t pos) {
+  return static_cast<unsigned char>(data[pos]);
+}
+
+static uint32_t be16(std::string_view data, size_t pos) {
+  return (byte_at(data, pos) << 8) | byte_at(data, pos + 1);
+}
+
+static uint32_t be32(std::string_view data, size_t pos) {
+  return (be16(data, pos) << 16) | be16(data, pos + 2);
+}
+
+static uint32_t le16(std::string_view data, size_t pos) {
+  return byte_at(data, pos) | (byte_at(data, pos + 1) << 8);
+}
+
+static uint32_t le24(std::string_view data, size_t pos) {
+  return le16(data, pos) | (byte_at(data, pos + 2) << 16);
+}
+
+static uint32_t le32(std::string_view data, size_t pos) {
+  return le16(data, pos) | (le16(data, pos + 2) << 16);
+}
+
+static bool has_magic(std::string_view data, size_t pos,
+                      std::string_view magic) {
+  return data.size() >= pos + magic.size() &&
+         data.substr(pos, magic.size()) == magic;
+}
+
+// PNG：签名之后的第一个块为 IHDR，依次为宽、高（大端 32 位）
+static bool read_png_size(std::string_view data, uint32_t &w, uint32_t &h) {
+  if (!has_magic(data, 0, "\x89PNG\r\n\x1a\n") ||
+      !has_magic(data, 12, "IHDR") || data.size() < 24) {
+    return false;
+  }
+  w = be32(data, 16);
+  h = be32(data, 20);
+  return true;
+}
+
+// JPEG：逐个跳过标记段，直到遇到 SOF（帧头）段
+static bool read_jpeg_size(std::string_view data, uint32_t &w, uint32_t &h) {
+  if (!has_magic(data, 0, "\xff\xd8")) {
+    return false;
+  }
+  size_t pos = 2;
+  while (pos + 4 <= data.size()) {
+    if (byte_at(data, pos) != 0xFF) {
+      return false;
+    }
+    uint32_t marker = byte_at(data, pos + 1);
+    if (marker == 0xFF) {
+      ++pos; // 填充字节
+      continue;
+    }
+    pos += 2;
+    // 没有长度字段的独立标记（TEM、RST0~7）
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA) {
+      return false; // 在图像数据之前没有找到帧头
+    }
+
+    uint32_t length = be16(data, pos);
+    // SOF0~SOF15（不含 DHT、JPG、DAC）：精度 1 字节，之后为高、宽
+    bool is_sof = marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+                  marker != 0xC8 && marker != 0xCC;
+    if (is_sof) {
+      if (pos + 7 > data.size()) {
+        return false;
+      }
+      h = be16(data, pos + 3);
+      w = be16(data, pos + 5);
+      return true;
+    }
+    if (length < 2) {
+      return false;
+    }
+    pos += length;
+  }
+  return false;
+}
+
+// GIF：逻辑屏幕描述符中的宽、高（小端 16 位）
+static bool read_gif_size(std::string_view data, uint32_t &w, uint32_t &h) {
+  if ((!has_magic(data, 0, "GIF87a") && !has_magic(data, 0, "GIF89a")) ||
+      data.size() < 10) {
+    return false;
+  }
+  w = le16(data, 6);
+  h = le16(data, 8);
+  return true;
+}
+
+// WebP：根据第一个块的类型（有损 VP8、无损 VP8L、扩展格式 VP8X）读取
+static bool read_webp_size(std::string_view data, uint32_t &w, uint32_t &h) {
+  if (!has_magic(data, 0, "RIFF") || !has_magic(data, 8, "WEBP")) {
+    return false;
+  }
+  if (has_magic(data, 12, "VP8 ") && data.size() >= 30 &&
+      has_magic(data, 23, "\x9d\x01\x2a")) {
+    w = le16(data, 26) & 0x3FFF;
+    h = le16(data, 28) & 0x3FFF;
+    return true;
+  }
+  if (has_magic(data, 12, "VP8L") && data.size() >= 25 &&
+      byte_at(data, 20) == 0x2F) {
+    uint32_t bits = le32(data, 21);
+    w = (bits & 0x3FFF) + 1;
+    h = ((bits >> 14) & 0x3FFF) + 1;
+    return true;
+  }
+  if (has_magic(data, 12, "VP8X") && data.size() >= 30) {
+    w = le24(data, 24) + 1;
+    h = le24(data, 27) + 1;
+    return true;
+  }
+  return false;
+}
+
+// BMP：旧式 OS/2 头为 16 位宽高，
+// 其余版本为 32 位有符号宽高（高为负表示自上而下）
+static bool read_bmp_size(std::string_view data, uint32_t &w, uint32_t &h) {
+  if (!has_magic(data, 0, "BM") || data.size() < 26) {
+    return false;
+  }
+  if (le32(data, 14) == 12) {
+    w = le16(data, 18);
+    h = le16(data, 20);
+    return true;
+  }
+  int32_t width = static_cast<int32_t>(le32(data, 18));
+  int32_t height = static_cast<int32_t>(le32(data, 22));
+  if (width <= 0 || height == INT32_MIN) {
+    return false;
+  }
+  w = static_cast<uint32_t>(width);
+  h = static_cast<uint32_t>(height < 0 ? -height : height);
+  return true;
+}
+
+// 从图片文件头中读取宽高
+bool read_image_size(std::string_view data, int &width, int &height) {
+  uint32_t w = 0, h = 0;
+  if (!read_png_size(data, w, h) && !read_jpeg_size(data, w, h) &&
+      !read_gif_size(data, w, h) && !read_webp_size(data, w, h) &&
+      !read_bmp_size(data, w, h)) {
+    return false;
+  }
+  // 拒绝 0 和超出 int 范围的异常值
+  if (w == 0 || h == 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF) {
+    return false;
+  }
+  width = static_cast<int>(w);
+  height = static_cast<int>(h);
+  return true;
+}
@@ -0,0 +1,10 @@
+#ifndef IMAGE_INFO_H
+#define IMAGE_INFO_H
+
+#include <string_view>
+
+// 从图片文件头中读取宽高（PNG/JPEG/GIF/WebP/BMP），只解析头部，不解码像素；
+// 无法识别或数据不完整时返回 false
+bool read_image_size(std::string_view data, int &width, int &height);
+
+#endif // IMAGE_INFO_H
@@ -0,0 +1,419 @@
+#include "image_resize.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <zlib.h>
+
+// 解码时允许的最大像素数，防止恶意图片耗尽内存；
+// 解码加缩放的峰值约为每像素 20 字节（RGBA 4 字节 + 水平缩放的浮点缓冲 16 字节），
+// 上限 8M 像素时单个请求最多占用约 160MB
+#define MAX_DECODE_PIXELS (8LL * 1024 * 1024)
+
+static const unsigned char PNG_SIGNATURE[8] = {0x89, 'P',  'N',  'G',
+                                               '\r', '\n', 0x1A, '\n'};
+
+static uint32_t read_be32(const unsigned char *p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+         (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+static void append_be32(std::string &out, uint32_t v) {
+  out.push_back(static_cast<char>((v >> 24) & 0xFF));
+  out.push_back(static_cast<char>((v >> 16) & 0xFF));
+  out.push_back(static_cast<char>((v >> 8) & 0xFF));
+  out.push_back(static_cast<char>(v & 0xFF));
+}
+
+static int paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+// 还原一行 PNG 过滤（prev 为上一行的原始数据，首行为全零）
+static bool unfilter_row(int filter, unsigned char *row,
+                         const unsigned char *prev, size_t len, size_t bpp) {
+  switch (filter) {
+  case 0:
+    return true;
+  case 1:
+    for (size_t i = bpp; i < len; ++i) {
+      row[i] = static_cast<unsigned char>(row[i] + row[i - bpp]);
+    }
+    return true;
+  case 2:
+    for (size_t i = 0; i < len; ++i) {
+      row[i] = static_cast<unsigned char>(row[i] + prev[i]);
+    }
+    return true;
+  case 3:
+    for (size_t i = 0; i < len; ++i) {
+      int left = i >= bpp ? row[i - bpp] : 0;
+      row[i] = static_cast<unsigned char>(row[i] + ((left + prev[i]) >> 1));
+    }
+    return true;
+  case 4:
+    for (size_t i = 0; i < len; ++i) {
+      int left = i >= bpp ? row[i - bpp] : 0;
+      int upper_left = i >= bpp ? prev[i - bpp] : 0;
+      row[i] =
+          static_cast<unsigned char>(row[i] + paeth(left, prev[i], upper_left));
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+// 解码 PNG 数据为 RGBA 图片（不支持隔行扫描）
+bool decode_png(const std::string &data, Image &out) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(data.data());
+  size_t size = data.size();
+  if (size < 8 || std::memcmp(bytes, PNG_SIGNATURE, 8) != 0) {
+    return false;
+  }
+
+  uint32_t width = 0, height = 0;
+  int bit_depth = 0, color_type = -1;
+  std::vector<unsigned char> palette;       // RGB 三元组
+  std::vector<unsigned char> palette_alpha; // tRNS 透明度
+  std::string idat;
+
+  // 遍历所有 chunk
+  size_t pos = 8;
+  while (pos + 8 <= size) {
+    // 剩余数据不足一个完整 chunk（长度 + 类型 + CRC）时视为损坏
+    if (size - pos < 12) {
+      return false;
+    }
+    uint32_t len = read_be32(bytes + pos);
+    const char *type = reinterpret_cast<const char *>(bytes + pos + 4);
+    if (len > size - pos - 12) {
+      return false;
+    }
+    const unsigned char *chunk = bytes + pos + 8;
+
+    if (std::memcmp(type, "IHDR", 4) == 0) {
+      if (len < 13) {
+        return false;
+      }
+      width = read_be32(chunk);
+      height = read_be32(chunk + 4);
+      bit_depth = chunk[8];
+      color_type = chunk[9];
+      if (chunk[12] != 0) {
+        return false; // 隔行扫描不支持
+      }
+    } else if (std::memcmp(type, "PLTE", 4) == 0) {
+      palette.assign(chunk, chunk + len);
+    } else if (std::memcmp(type, "tRNS", 4) == 0) {
+      palette_alpha.assign(chunk, chunk + len);
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      idat.append(reinterpret_cast<const char *>(chunk), len);
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      break;
+    }
+    pos += 12 + static_cast<size_t>(len);
+  }
+
+  if (width == 0 || height == 0 || idat.empty() ||
+      static_cast<long long>(width) * height > MAX_DECODE_PIXELS) {
+    return false;
+  }
+
+  int samples;
+  switch (color_type) {
+  case 0:
+    samples = 1;
+    break;
+  case 2:
+    samples = 3;
+    break;
+  case 3:
+    samples = 1;
+    break;
+  case 4:
+    samples = 2;
+    break;
+  case 6:
+    samples = 4;
+    break;
+  default:
+    return false;
+  }
+  if (bit_depth != 1 && bit_depth != 2 && bit_depth != 4 && bit_depth != 8 &&
+      bit_depth != 16) {
+    return false;
+  }
+  if (color_type == 3 && (bit_depth > 8 || palette.empty())) {
+    return false;
+  }
+
+  size_t bits_per_pixel = static_cast<size_t>(samples) * bit_depth;
+  size_t row_bytes = (width * bits_per_pixel + 7) / 8;
+  size_t bpp = std::max<size_t>(1, bits_per_pixel / 8);
+
+  // 解压 IDAT 数据（每行前带 1 字节过滤类型）
+  std::vector<unsigned char> raw((row_bytes + 1) * height);
+  uLongf raw_size = static_cast<uLongf>(raw.size());
+  int ret = uncompress(raw.data(), &raw_size,
+                       reinterpret_cast<const Bytef *>(idat.data()),
+                       static_cast<uLong>(idat.size()));
+  if ((ret != Z_OK && ret != Z_BUF_ERROR) || raw_size != raw.size()) {
+    return false;
+  }
+
+  out.width = static_cast<int>(width);
+  out.height = static_cast<int>(height);
+  out.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+  std::vector<unsigned char> zero_row(row_bytes, 0);
+  const unsigned char *prev = zero_row.data();
+  int max_value = (1 << std::min(bit_depth, 8)) - 1;
+
+  for (uint32_t y = 0; y < height; ++y) {
+    unsigned char *line = raw.data() + y * (row_bytes + 1);
+    unsigned char *row = line + 1;
+    if (!unfilter_row(line[0], row, prev, row_bytes, bpp)) {
+      return false;
+    }
+    prev = row;
+
+    // 读取第 i 个样本（统一缩放到 0~255）
+    auto sample = [&](size_t i) -> int {
+      if (bit_depth == 8) {
+        return row[i];
+      }
+      if (bit_depth == 16) {
+        return row[i * 2];
+      }
+      size_t bit = i * bit_depth;
+      int v = (row[bit / 8] >> (8 - bit_depth - bit % 8)) & max_value;
+      return color_type == 3 ? v : v * 255 / max_value;
+    };
+
+    unsigned char *dst = out.pixels.data() + static_cast<size_t>(y) * width * 4;
+    for (uint32_t x = 0; x < width; ++x, dst += 4) {
+      size_t s = static_cast<size_t>(x) * samples;
+      switch (color_type) {
+      case 0:
+        dst[0] = dst[1] = dst[2] = static_cast<unsigned char>(sample(s));
+        dst[3] = 255;
+        break;
+      case 2:
+        dst[0] = static_cast<unsigned char>(sample(s));
+        dst[1] = static_cast<unsigned char>(sample(s + 1));
+        dst[2] = static_cast<unsigned char>(sample(s + 2));
+        dst[3] = 255;
+        break;
+      case 3: {
+        size_t index = static_cast<size_t>(sample(s));
+        if (index * 3 + 2 >= palette.size()) {
+          return false;
+        }
+        dst[0] = palette[index * 3];
+        dst[1] = palette[index * 3 + 1];
+        dst[2] = palette[index * 3 + 2];
+        dst[3] = index < palette_alpha.size() ? palette_alpha[index] : 255;
+        break;
+      }
+      case 4:
+        dst[0] = dst[1] = dst[2] = static_cast<unsigned char>(sample(s));
+        dst[3] = static_cast<unsigned char>(sample(s + 1));
+        break;
+      case 6:
+        dst[0] = static_cast<unsigned char>(sample(s));
+        dst[1] = static_cast<unsigned char>(sample(s + 1));
+        dst[2] = static_cast<unsigned char>(sample(s + 2));
+        dst[3] = static_cast<unsigned char>(sample(s + 3));
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
+static void append_chunk(std::string &out, const char *type,
+                         const std::string &payload) {
+  append_be32(out, static_cast<uint32_t>(payload.size()));
+  size_t type_pos = out.size();
+  out.append(type, 4);
+  out.append(payload);
+  uLong crc = crc32(0L, Z_NULL, 0);
+  crc = crc32(crc, reinterpret_cast<const Bytef *>(out.data() + type_pos),
+              static_cast<uInt>(4 + payload.size()));
+  append_be32(out, static_cast<uint32_t>(crc));
+}
+
+// 将 RGBA 图片编码为 PNG 数据
+bool encode_png(const Image &image, std::string &out) {
+  if (image.width <= 0 || image.height <= 0 ||
+      image.pixels.size() !=
+          static_cast<size_t>(image.width) * image.height * 4) {
+    return false;
+  }
+
+  size_t row_bytes = static_cast<size_t>(image.width) * 4;
+  std::vector<unsigned char> raw((row_bytes + 1) * image.height);
+  std::vector<unsigned char> candidate(row_bytes);
+  std::vector<unsigned char> zero_row(row_bytes, 0);
+
+  // 每行在 None/Sub/Up/Paeth 中选择绝对值和最小的过滤方式
+  for (int y = 0; y < image.height; ++y) {
+    const unsigned char *row = image.pixels.data() + y * row_bytes;
+    const unsigned char *prev =
+        y > 0 ? image.pixels.data() + (y - 1) * row_bytes : zero_row.data();
+    unsigned char *dst = raw.data() + y * (row_bytes + 1);
+
+    long best_sum = -1;
+    for (int filter : {0, 1, 2, 4}) {
+      long sum = 0;
+      for (size_t i = 0; i < row_bytes; ++i) {
+        int left = i >= 4 ? row[i - 4] : 0;
+        int upper_left = i >= 4 ? prev[i - 4] : 0;
+        int predictor = filter == 1   ? left
+                        : filter == 2 ? prev[i]
+                        : filter == 4 ? paeth(left, prev[i], upper_left)
+                                      : 0;
+        candidate[i] = static_cast<unsigned char>(row[i] - predictor);
+        sum += static_cast<signed char>(candidate[i]) < 0
+                   ? -static_cast<signed char>(candidate[i])
+                   : candidate[i];
+      }
+      if (best_sum < 0 || sum < best_sum) {
+        best_sum = sum;
+        dst[0] = static_cast<unsigned char>(filter);
+        std::memcpy(dst + 1, candidate.data(), row_bytes);
+      }
+    }
+  }
+
+  uLongf compressed_size = compressBound(static_cast<uLong>(raw.size()));
+  std::string compressed(compressed_size, '\0');
+  if (compress2(reinterpret_cast<Bytef *>(&compressed[0]), &compressed_size,
+                raw.data(), static_cast<uLong>(raw.size()),
+                Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return false;
+  }
+  compressed.resize(compressed_size);
+
+  std::string ihdr;
+  append_be32(ihdr, static_cast<uint32_t>(image.width));
+  append_be32(ihdr, static_cast<uint32_t>(image.height));
+  ihdr.push_back(8); // 位深
+  ihdr.push_back(6); // RGBA
+  ihdr.push_back(0); // 压缩方式
+  ihdr.push_back(0); // 过滤方式
+  ihdr.push_back(0); // 非隔行
+
+  out.assign(reinterpret_cast<const char *>(PNG_SIGNATURE), 8);
+  append_chunk(out, "IHDR", ihdr);
+  append_chunk(out, "IDAT", compressed);
+  append_chunk(out, "IEND", std::string());
+  return true;
+}
+
+// 一个输出像素对应的源像素区间及权重
+struct Contribution {
+  int start;
+  std::vector<float> weights;
+};
+
+// 计算面积平均采样的权重表（每个输出像素覆盖 scale 个源像素）
+static std::vector<Contribution> make_contributions(int src_size,
+                                                    int dst_size) {
+  std::vector<Contribution> table(dst_size);
+  double scale = static_cast<double>(src_size) / dst_size;
+  for (int i = 0; i < dst_size; ++i) {
+    double begin = i * scale;
+    double end = std::min<double>(src_size, (i + 1) * scale);
+    int first = static_cast<int>(begin);
+    int last = std::min(src_size - 1, static_cast<int>(std::ceil(end)) - 1);
+    Contribution &c = table[i];
+    c.start = first;
+    for (int s = first; s <= last; ++s) {
+      double overlap =
+          std::min<double>(end, s + 1) - std::max<double>(begin, s);
+      c.weights.push_back(static_cast<float>(overlap / (end - begin)));
+    }
+  }
+  return table;
+}
+
+// 按目标宽度等比缩放图片（面积平均采样，适合缩小）
+void resize_image(const Image &src, int width, Image &dst) {
+  int height = std::max(1, static_cast<int>(std::lround(
+                               static_cast<double>(src.height) * width /
+                               src.width)));
+  dst.width = width;
+  dst.height = height;
+  dst.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+  auto columns = make_contributions(src.width, width);
+  auto rows = make_contributions(src.height, height);
+
+  // 水平方向：逐行转为预乘 alpha 的浮点数后缩放，结果保存在中间缓冲区
+  // 内层循环只处理连续的 float 数组，便于编译器向量化
+  std::vector<float> horizontal(static_cast<size_t>(width) * src.height * 4);
+  std::vector<float> line(static_cast<size_t>(src.width) * 4);
+  for (int y = 0; y < src.height; ++y) {
+    const uint8_t *in =
+        src.pixels.data() + static_cast<size_t>(y) * src.width * 4;
+    for (int x = 0; x < src.width; ++x) {
+      float alpha = in[x * 4 + 3] * (1.0f / 255.0f);
+      line[x * 4] = in[x * 4] * alpha;
+      line[x * 4 + 1] = in[x * 4 + 1] * alpha;
+      line[x * 4 + 2] = in[x * 4 + 2] * alpha;
+      line[x * 4 + 3] = in[x * 4 + 3];
+    }
+
+    float *out = horizontal.data() + static_cast<size_t>(y) * width * 4;
+    for (int x = 0; x < width; ++x) {
+      const Contribution &c = columns[x];
+      const float *p = line.data() + static_cast<size_t>(c.start) * 4;
+      float acc[4] = {0, 0, 0, 0};
+      for (size_t k = 0; k < c.weights.size(); ++k, p += 4) {
+        float w = c.weights[k];
+        for (int ch = 0; ch < 4; ++ch) {
+          acc[ch] += p[ch] * w;
+        }
+      }
+      std::memcpy(out + x * 4, acc, sizeof(acc));
+    }
+  }
+
+  // 垂直方向：整行累加，再还原为非预乘的 8 位 RGBA
+  size_t row_floats = static_cast<size_t>(width) * 4;
+  std::vector<float> acc(row_floats);
+  for (int y = 0; y < height; ++y) {
+    const Contribution &c = rows[y];
+    std::fill(acc.begin(), acc.end(), 0.0f);
+    for (size_t k = 0; k < c.weights.size(); ++k) {
+      const float *in = horizontal.data() + (c.start + k) * row_floats;
+      float w = c.weights[k];
+      for (size_t i = 0; i < row_floats; ++i) {
+        acc[i] += in[i] * w;
+      }
+    }
+
+    uint8_t *out = dst.pixels.data() + static_cast<size_t>(y) * row_floats;
+    for (int x = 0; x < width; ++x) {
+      float alpha = acc[x * 4 + 3];
+      float unpremultiply = alpha > 0.0f ? 255.0f / alpha : 0.0f;
+      for (int ch = 0; ch < 3; ++ch) {
+        float v = acc[x * 4 + ch] * unpremultiply;
+        out[x * 4 + ch] =
+            static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, v + 0.5f)));
+      }
+      out[x * 4 + 3] =
+          static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, alpha + 0.5f)));
+    }
+  }
+}
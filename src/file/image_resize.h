@@ -0,0 +1,27 @@
+#ifndef IMAGE_RESIZE_H
+#define IMAGE_RESIZE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 允许的最大缩放宽度
+#define MAX_RESIZE_WIDTH 4096
+
+// 解码后的图片（统一为 8 位 RGBA）
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels; // width * height * 4 字节
+};
+
+// 解码 PNG 数据为 RGBA 图片（不支持隔行扫描）
+bool decode_png(const std::string &data, Image &out);
+
+// 将 RGBA 图片编码为 PNG 数据
+bool encode_png(const Image &image, std::string &out);
+
+// 按目标宽度等比缩放图片（面积平均采样，适合缩小）
+void resize_image(const Image &src, int width, Image &dst);
+
+#endif // IMAGE_RESIZE_H
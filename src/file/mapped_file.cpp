@@ -0,0 +1,154 @@
+#include "mapped_file.h"
+#include <algorithm>
+#include <utility>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+// Windows 下退化为按窗口读取到固定缓冲区
+MappedFile::MappedFile(const std::string &path)
+    : file_(path, std::ios::binary | std::ios::ate) {
+  if (file_.is_open()) {
+    size_ = static_cast<size_t>(file_.tellg());
+    buffer_.resize(256 * 1024);
+  }
+}
+
+MappedFile::MappedFile(std::shared_ptr<const FileHandle> handle)
+    : MappedFile(handle->path) {}
+
+MappedFile::~MappedFile() = default;
+
+bool MappedFile::is_open() const { return file_.is_open(); }
+
+bool MappedFile::read(size_t offset, size_t length, const Callback &callback) {
+  if (offset >= size_) {
+    return false;
+  }
+  size_t n = (std::min)({length, buffer_.size(), size_ - offset});
+  file_.clear();
+  file_.seekg(static_cast<std::streamoff>(offset));
+  if (!file_.read(buffer_.data(), static_cast<std::streamsize>(n))) {
+    return false;
+  }
+  return callback(buffer_.data(), n);
+}
+
+size_t MappedFile::copy(size_t offset, char *buffer, size_t length) {
+  if (offset >= size_) {
+    return 0;
+  }
+  file_.clear();
+  file_.seekg(static_cast<std::streamoff>(offset));
+  file_.read(buffer, static_cast<std::streamsize>(length));
+  return static_cast<size_t>(file_.gcount());
+}
+
+void MappedFile::prefetch(size_t, size_t) {}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) {
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ == -1) {
+    return;
+  }
+
+  struct stat sb;
+  if (fstat(fd_, &sb) == -1) {
+    ::close(fd_);
+    fd_ = -1;
+    return;
+  }
+  size_ = static_cast<size_t>(sb.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+MappedFile::MappedFile(std::shared_ptr<const FileHandle> handle)
+    : handle_(std::move(handle)) {
+  fd_ = handle_->fd;
+  size_ = handle_->size;
+}
+
+MappedFile::~MappedFile() {
+  if (window_) {
+    munmap(window_, window_size_);
+  }
+  if (fd_ != -1 && !handle_) {
+    ::close(fd_);
+  }
+}
+
+bool MappedFile::is_open() const { return fd_ != -1; }
+
+// 映射 offset 所在的窗口，并提示内核按顺序预读
+bool MappedFile::map_window(size_t offset) {
+  size_t start = offset / MAPPED_WINDOW_SIZE * MAPPED_WINDOW_SIZE;
+  if (window_ && window_offset_ == start) {
+    return true;
+  }
+  if (window_) {
+    munmap(window_, window_size_);
+    window_ = nullptr;
+  }
+
+  size_t len =
+      (std::min)(static_cast<size_t>(MAPPED_WINDOW_SIZE), size_ - start);
+  void *addr = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd_,
+                    static_cast<off_t>(start));
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  madvise(addr, len, MADV_SEQUENTIAL);
+
+  window_ = static_cast<char *>(addr);
+  window_offset_ = start;
+  window_size_ = len;
+  return true;
+}
+
+bool MappedFile::read(size_t offset, size_t length, const Callback &callback) {
+  if (offset >= size_ || !map_window(offset)) {
+    return false;
+  }
+  size_t begin = offset - window_offset_;
+  size_t n = (std::min)(length, window_size_ - begin);
+  return callback(window_ + begin, n);
+}
+
+size_t MappedFile::copy(size_t offset, char *buffer, size_t length) {
+  size_t done = 0;
+  while (done < length) {
+    ssize_t n = pread(fd_, buffer + done, length - done,
+                      static_cast<off_t>(offset + done));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break; // 出错或已到文件末尾（文件被截断）
+    }
+    done += static_cast<size_t>(n);
+  }
+  return done;
+}
+
+void MappedFile::prefetch(size_t offset, size_t length) {
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(length),
+                POSIX_FADV_WILLNEED);
+#else
+  (void)offset;
+  (void)length;
+#endif
+}
+
+#endif
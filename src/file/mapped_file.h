@@ -0,0 +1,64 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include "file_handle_cache.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+#ifdef _WIN32
+#include <fstream>
+#include <vector>
+#endif
+
+// 每次映射的窗口大小（必须是页大小的整数倍）
+#define MAPPED_WINDOW_SIZE (4 * 1024 * 1024) // 4MB
+
+// 按固定大小窗口映射的只读文件：同一时刻只映射一个窗口，
+// 无论文件多大，每个连接占用的内存都是常量
+class MappedFile {
+public:
+  using Callback = std::function<bool(const char *data, size_t len)>;
+
+  explicit MappedFile(const std::string &path);
+  // 复用句柄缓存中已打开的文件，不再重新打开
+  explicit MappedFile(std::shared_ptr<const FileHandle> handle);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool is_open() const;
+  size_t size() const { return size_; }
+
+  // 读取从 offset 开始、最多 length 字节的数据（不跨窗口），通过回调输出；
+  // 回调只应把映射页直接交给内核发送（文件被截断时 send 返回 EFAULT），
+  // 需要在用户态读取数据时使用 copy
+  bool read(size_t offset, size_t length, const Callback &callback);
+
+  // 用 pread 把从 offset 开始的 length 字节复制到 buffer，不经过映射：
+  // 文件在读取期间被截断时返回实际读取的字节数，而不是触发 SIGBUS
+  size_t copy(size_t offset, char *buffer, size_t length);
+
+  // 提示内核异步预读 [offset, offset + length) 的数据（不阻塞）
+  void prefetch(size_t offset, size_t length);
+
+private:
+  size_t size_ = 0;
+#ifdef _WIN32
+  std::ifstream file_;
+  std::vector<char> buffer_;
+#else
+  bool map_window(size_t offset);
+
+  // 共享的文件句柄，文件由句柄负责关闭
+  std::shared_ptr<const FileHandle> handle_;
+  int fd_ = -1;
+  char *window_ = nullptr;
+  size_t window_offset_ = 0;
+  size_t window_size_ = 0;
+#endif
+};
+
+#endif // MAPPED_FILE_H
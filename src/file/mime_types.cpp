@@ -0,0 +1,262 @@
+#include "mime_types.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// 哈希表槽位数（2 的幂），远大于扩展名个数，便于找到无冲突的种子
+#define MIME_TABLE_SIZE 256
+// 表中最长扩展名的长度，更长的扩展名直接判定为未知
+#define MIME_MAX_EXT_LENGTH 8
+
+namespace {
+
+struct MimeEntry {
+  std::string_view ext;
+  MimeInfo info;
+};
+
+constexpr MimeEntry MIME_ENTRIES[] = {
+    // Text types
+    {".css", {"text/css; charset=utf-8", "other"}},
+    {".csv", {"text/csv; charset=utf-8", "other"}},
+    {".txt", {"text/plain; charset=utf-8", "other"}},
+    {".vtt", {"text/vtt; charset=utf-8", "other"}},
+    {".html", {"text/html; charset=utf-8", "other"}},
+    {".htm", {"text/html; charset=utf-8", "other"}},
+    {".js", {"text/javascript; charset=utf-8", "other"}},
+    {".mjs", {"text/javascript; charset=utf-8", "other"}},
+    // Image types
+    {".apng", {"image/apng", "other"}},
+    {".avif", {"image/avif", "other"}},
+    {".bmp", {"image/bmp", "image"}},
+    {".gif", {"image/gif", "image"}},
+    {".heic", {"image/heic", "other"}},
+    {".heif", {"image/heif", "other"}},
+    {".png", {"image/png", "image"}},
+    {".svg", {"image/svg+xml", "image"}},
+    {".webp", {"image/webp", "image"}},
+    {".ico", {"image/x-icon", "image"}},
+    {".tif", {"image/tiff", "other"}},
+    {".tiff", {"image/tiff", "other"}},
+    {".jpg", {"image/jpeg", "image"}},
+    {".jpeg", {"image/jpeg", "image"}},
+    // Video types
+    {".mp4", {"video/mp4", "video"}},
+    {".mpeg", {"video/mpeg", "video"}},
+    {".webm", {"video/webm", "video"}},
+    {".avi", {"video/x-msvideo", "video"}},
+    {".mov", {"video/quicktime", "video"}},
+    {".wmv", {"application/octet-stream", "video"}},
+    {".flv", {"application/octet-stream", "video"}},
+    {".mkv", {"application/octet-stream", "video"}},
+    {".m4v", {"application/octet-stream", "video"}},
+    {".3gp", {"application/octet-stream", "video"}},
+    {".mpg", {"application/octet-stream", "video"}},
+    // Audio types
+    {".mp3", {"audio/mp3", "other"}},
+    {".m4a", {"audio/mp4", "other"}},
+    {".mpga", {"audio/mpeg", "other"}},
+    {".weba", {"audio/webm", "other"}},
+    {".wav", {"audio/wave", "other"}},
+    // Font types
+    {".otf", {"font/otf", "other"}},
+    {".ttf", {"font/ttf", "other"}},
+    {".woff", {"font/woff", "other"}},
+    {".woff2", {"font/woff2", "other"}},
+    // Application types
+    {".7z", {"application/x-7z-compressed", "other"}},
+    {".atom", {"application/atom+xml", "other"}},
+    {".pdf", {"application/pdf", "other"}},
+    {".json", {"application/json", "other"}},
+    {".rss", {"application/rss+xml", "other"}},
+    {".tar", {"application/x-tar", "other"}},
+    {".xhtml", {"application/xhtml+xml", "other"}},
+    {".xht", {"application/xhtml+xml", "other"}},
+    {".xslt", {"application/xslt+xml", "other"}},
+    {".xml", {"application/xml", "other"}},
+    {".gz", {"application/gzip", "other"}},
+    {".zip", {"application/zip", "other"}},
+    {".wasm", {"application/wasm", "other"}},
+};
+
+constexpr size_t MIME_ENTRY_COUNT =
+    sizeof(MIME_ENTRIES) / sizeof(MIME_ENTRIES[0]);
+static_assert(MIME_ENTRY_COUNT < 0xFF, "too many MIME entries");
+
+constexpr MimeInfo UNKNOWN_MIME = {"application/octet-stream", "other"};
+
+constexpr char to_lower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// 大小写不敏感的 FNV-1a 哈希，seed 用于寻找无冲突的哈希函数
+constexpr uint32_t hash_ext(std::string_view ext, uint32_t seed) {
+  uint32_t h = 2166136261u ^ seed;
+  for (char c : ext) {
+    h ^= static_cast<unsigned char>(to_lower(c));
+    h *= 16777619u;
+  }
+  return h ^ (h >> 15);
+}
+
+// 判断在该种子下所有扩展名是否落在不同的槽位
+constexpr bool is_perfect_seed(uint32_t seed) {
+  bool used[MIME_TABLE_SIZE] = {};
+  for (const auto &entry : MIME_ENTRIES) {
+    uint32_t slot = hash_ext(entry.ext, seed) % MIME_TABLE_SIZE;
+    if (used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+  return true;
+}
+
+constexpr uint32_t find_perfect_seed() {
+  uint32_t seed = 0;
+  while (!is_perfect_seed(seed)) {
+    ++seed;
+  }
+  return seed;
+}
+
+constexpr uint32_t MIME_SEED = find_perfect_seed();
+
+// 槽位 -> 表项下标，0xFF 表示空槽
+struct MimeTable {
+  uint8_t slots[MIME_TABLE_SIZE];
+};
+
+constexpr MimeTable build_mime_table() {
+  MimeTable table = {};
+  for (auto &slot : table.slots) {
+    slot = 0xFF;
+  }
+  for (size_t i = 0; i < MIME_ENTRY_COUNT; ++i) {
+    table.slots[hash_ext(MIME_ENTRIES[i].ext, MIME_SEED) % MIME_TABLE_SIZE] =
+        static_cast<uint8_t>(i);
+  }
+  return table;
+}
+
+constexpr MimeTable MIME_TABLE = build_mime_table();
+
+bool equals_ignore_case(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (to_lower(a[i]) != to_lower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// 根据扩展名查找类型信息
+const MimeInfo &lookup_mime(std::string_view ext) {
+  if (ext.size() > MIME_MAX_EXT_LENGTH) {
+    return UNKNOWN_MIME;
+  }
+  uint8_t index = MIME_TABLE.slots[hash_ext(ext, MIME_SEED) % MIME_TABLE_SIZE];
+  if (index == 0xFF || !equals_ignore_case(MIME_ENTRIES[index].ext, ext)) {
+    return UNKNOWN_MIME;
+  }
+  return MIME_ENTRIES[index].info;
+}
+
+namespace {
+
+// 品牌对应的扩展名，rank 越小越优先（如 mif1 只说明是 HEIF 容器，
+// 同时列出 avif 时应识别为 AVIF）
+struct FtypBrand {
+  std::string_view brand;
+  const char *ext;
+  int rank;
+};
+
+constexpr FtypBrand FTYP_BRANDS[] = {
+    {"avif", ".avif", 0}, {"avis", ".avif", 0}, {"heic", ".heic", 1},
+    {"heix", ".heic", 1}, {"heim", ".heic", 1}, {"heis", ".heic", 1},
+    {"hevc", ".heic", 1}, {"M4A ", ".m4a", 2},  {"qt  ", ".mov", 3},
+    {"M4V ", ".mp4", 4},  {"isom", ".mp4", 4},  {"iso2", ".mp4", 4},
+    {"iso4", ".mp4", 4},  {"iso5", ".mp4", 4},  {"iso6", ".mp4", 4},
+    {"mp41", ".mp4", 4},  {"mp42", ".mp4", 4},  {"avc1", ".mp4", 4},
+    {"dash", ".mp4", 4},  {"mif1", ".heif", 5}, {"msf1", ".heif", 5},
+};
+
+} // namespace
+
+// 从 ftyp 盒的主品牌（第 8 字节）和兼容品牌（第 16 字节到盒结束）中
+// 选出优先级最高的类型，没有已知品牌时返回 nullptr
+static const char *ftyp_extension(std::string_view data) {
+  const FtypBrand *best = nullptr;
+  auto consider = [&best, &data](size_t pos) {
+    for (const auto &entry : FTYP_BRANDS) {
+      if (data.substr(pos, 4) == entry.brand &&
+          (!best || entry.rank < best->rank)) {
+        best = &entry;
+      }
+    }
+  };
+
+  if (data.size() >= 12) {
+    consider(8);
+  }
+  size_t box_size = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    box_size = (box_size << 8) | static_cast<unsigned char>(data[i]);
+  }
+  size_t end = (std::min)(box_size, data.size());
+  for (size_t pos = 16; pos + 4 <= end; pos += 4) {
+    consider(pos);
+  }
+  return best ? best->ext : nullptr;
+}
+
+// 根据文件开头的魔数识别类型
+const MimeInfo *sniff_mime(std::string_view data) {
+  auto starts_with = [&data](size_t offset, std::string_view magic) {
+    return data.size() >= offset + magic.size() &&
+           data.substr(offset, magic.size()) == magic;
+  };
+
+  if (starts_with(0, "\x89PNG\r\n\x1a\n")) {
+    return &lookup_mime(".png");
+  }
+  if (starts_with(0, "\xff\xd8\xff")) {
+    return &lookup_mime(".jpg");
+  }
+  if (starts_with(0, "GIF87a") || starts_with(0, "GIF89a")) {
+    return &lookup_mime(".gif");
+  }
+  if (starts_with(0, "RIFF") && starts_with(8, "WEBP")) {
+    return &lookup_mime(".webp");
+  }
+  // ISO 基础媒体文件：第 4 字节起为 ftyp 盒，按主品牌和兼容品牌区分
+  // AVIF/HEIC 图片、M4A 音频、QuickTime 和 MP4 视频，品牌未知时按扩展名判断
+  if (starts_with(4, "ftyp")) {
+    const char *ext = ftyp_extension(data);
+    return ext ? &lookup_mime(ext) : nullptr;
+  }
+  // EBML 头：文档类型为 webm 时是 WebM，否则是 Matroska
+  if (starts_with(0, "\x1a\x45\xdf\xa3")) {
+    bool webm = data.substr(0, 64).find("webm") != std::string_view::npos;
+    return &lookup_mime(webm ? ".webm" : ".mkv");
+  }
+  if (starts_with(0, "%PDF-")) {
+    return &lookup_mime(".pdf");
+  }
+  if (starts_with(0, "PK\x03\x04") || starts_with(0, "PK\x05\x06")) {
+    return &lookup_mime(".zip");
+  }
+  return nullptr;
+}
+
+// 确定上传文件的类型
+const MimeInfo &detect_mime(std::string_view data, std::string_view ext) {
+  const MimeInfo *sniffed = sniff_mime(data);
+  return sniffed ? *sniffed : lookup_mime(ext);
+}
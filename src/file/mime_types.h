@@ -0,0 +1,24 @@
+#ifndef MIME_TYPES_H
+#define MIME_TYPES_H
+
+#include <string_view>
+
+// 扩展名对应的 Content-Type 和文件类型（image/video/other）
+struct MimeInfo {
+  const char *content_type;
+  const char *file_type;
+};
+
+// 根据扩展名（含点，如 ".png"，大小写不敏感）查找类型信息，
+// 使用编译期生成的完美哈希表，一次哈希加一次比较即可得到结果；
+// 未知扩展名返回 application/octet-stream / other
+const MimeInfo &lookup_mime(std::string_view ext);
+
+// 根据文件开头的魔数识别类型（PNG/JPEG/GIF/WebP/AVIF/HEIC/MP4/M4A/
+// QuickTime/WebM/Matroska/PDF/ZIP），无法识别时返回 nullptr
+const MimeInfo *sniff_mime(std::string_view data);
+
+// 确定上传文件的类型：优先按内容识别，识别不出时按扩展名判断
+const MimeInfo &detect_mime(std::string_view data, std::string_view ext);
+
+#endif // MIME_TYPES_H
@@ -0,0 +1,280 @@
+#include "mp4_info.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+// ISO 基础媒体文件中的一个盒（box / atom）
+struct Box {
+  std::string_view type;
+  size_t offset = 0;      // 盒在数据中的起始位置
+  size_t header_size = 0; // 8，使用 64 位长度时为 16
+  size_t size = 0;        // 含盒头的总长度
+
+  size_t payload() const { return offset + header_size; }
+  size_t end() const { return offset + size; }
+};
+
+uint32_t byte_at(std::string_view data, size_t pos) {
+  return static_cast<unsigned char>(data[pos]);
+}
+
+uint32_t be32(std::string_view data, size_t pos) {
+  return (byte_at(data, pos) << 24) | (byte_at(data, pos + 1) << 16) |
+         (byte_at(data, pos + 2) << 8) | byte_at(data, pos + 3);
+}
+
+uint64_t be64(std::string_view data, size_t pos) {
+  return (static_cast<uint64_t>(be32(data, pos)) << 32) | be32(data, pos + 4);
+}
+
+void put_be32(std::string &data, size_t pos, uint32_t value) {
+  for (int i = 3; i >= 0; --i) {
+    data[pos + i] = static_cast<char>(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+void put_be64(std::string &data, size_t pos, uint64_t value) {
+  put_be32(data, pos, static_cast<uint32_t>(value >> 32));
+  put_be32(data, pos + 4, static_cast<uint32_t>(value));
+}
+
+// 读取位于 pos 的盒头，盒必须完整落在 [pos, end) 内
+bool read_box(std::string_view data, size_t pos, size_t end, Box &box) {
+  if (end - pos < 8) {
+    return false;
+  }
+  uint64_t size = be32(data, pos);
+  size_t header_size = 8;
+  if (size == 1) {
+    if (end - pos < 16) {
+      return false;
+    }
+    size = be64(data, pos + 8);
+    header_size = 16;
+  } else if (size == 0) {
+    size = end - pos; // 长度为 0 表示延伸到末尾
+  }
+  if (size < header_size || size > end - pos) {
+    return false;
+  }
+  box = {data.substr(pos + 4, 4), pos, header_size, static_cast<size_t>(size)};
+  return true;
+}
+
+// 在 [begin, end) 中查找第一个指定类型的盒
+bool find_box(std::string_view data, size_t begin, size_t end,
+              std::string_view type, Box &found) {
+  Box box;
+  for (size_t pos = begin; pos < end && read_box(data, pos, end, box);
+       pos += box.size) {
+    if (box.type == type) {
+      found = box;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool find_child(std::string_view data, const Box &parent, std::string_view type,
+                Box &found) {
+  return find_box(data, parent.payload(), parent.end(), type, found);
+}
+
+// 四字符代码只接受可打印 ASCII，避免把损坏的数据写入元数据
+bool is_printable(std::string_view code) {
+  for (char c : code) {
+    if (c < 0x20 || c > 0x7E) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// mvhd：时间刻度和时长，版本 1 使用 64 位时间字段
+void read_movie_header(std::string_view data, const Box &mvhd,
+                       Mp4Info &info) {
+  size_t p = mvhd.payload();
+  size_t length = mvhd.end() - p;
+  if (length < 20) {
+    return;
+  }
+  bool v1 = byte_at(data, p) == 1;
+  if (v1 && length < 32) {
+    return;
+  }
+  uint32_t timescale = be32(data, p + (v1 ? 20 : 12));
+  uint64_t duration = v1 ? be64(data, p + 24) : be32(data, p + 16);
+  // 全 1 表示时长未知
+  bool unknown = v1 ? duration == UINT64_MAX : duration == UINT32_MAX;
+  if (timescale != 0 && !unknown) {
+    info.duration = static_cast<double>(duration) / timescale;
+  }
+}
+
+// tkhd：显示宽高为 16.16 定点数，位于矩阵之后
+void read_track_size(std::string_view data, const Box &tkhd, Mp4Info &info) {
+  size_t p = tkhd.payload();
+  size_t length = tkhd.end() - p;
+  if (length < 1) {
+    return;
+  }
+  size_t width_pos = byte_at(data, p) == 1 ? 88 : 76;
+  if (length < width_pos + 8) {
+    return;
+  }
+  uint32_t width = be32(data, p + width_pos) >> 16;
+  uint32_t height = be32(data, p + width_pos + 4) >> 16;
+  if (width != 0 && height != 0) {
+    info.width = static_cast<int>(width);
+    info.height = static_cast<int>(height);
+  }
+}
+
+// trak：由 hdlr 判断轨道类型，由 stsd 的第一个采样描述得到编码
+void read_track(std::string_view data, const Box &trak, Mp4Info &info) {
+  Box mdia, hdlr, minf, stbl, stsd;
+  if (!find_child(data, trak, "mdia", mdia) ||
+      !find_child(data, mdia, "hdlr", hdlr) ||
+      hdlr.end() - hdlr.payload() < 12) {
+    return;
+  }
+  std::string_view handler = data.substr(hdlr.payload() + 8, 4);
+
+  std::string_view codec;
+  if (find_child(data, mdia, "minf", minf) &&
+      find_child(data, minf, "stbl", stbl) &&
+      find_child(data, stbl, "stsd", stsd) &&
+      stsd.end() - stsd.payload() >= 16 && be32(data, stsd.payload() + 4) > 0) {
+    codec = data.substr(stsd.payload() + 12, 4);
+    if (!is_printable(codec)) {
+      codec = {};
+    }
+  }
+
+  if (handler == "vide" && info.video_codec.empty()) {
+    info.video_codec = codec;
+    Box tkhd;
+    if (find_child(data, trak, "tkhd", tkhd)) {
+      read_track_size(data, tkhd, info);
+    }
+  } else if (handler == "soun" && info.audio_codec.empty()) {
+    info.audio_codec = codec;
+  }
+}
+
+// 把 moov 中所有落在 [from, to) 内的块偏移（stco/co64）加上 delta；
+// 32 位偏移溢出时返回 false
+bool shift_chunk_offsets(std::string &moov, size_t begin, size_t end,
+                         uint64_t from, uint64_t to, uint64_t delta) {
+  Box box;
+  for (size_t pos = begin; pos < end && read_box(moov, pos, end, box);
+       pos += box.size) {
+    if (box.type == "moov" || box.type == "trak" || box.type == "mdia" ||
+        box.type == "minf" || box.type == "stbl") {
+      if (!shift_chunk_offsets(moov, box.payload(), box.end(), from, to,
+                               delta)) {
+        return false;
+      }
+      continue;
+    }
+    bool is_co64 = box.type == "co64";
+    if (box.type != "stco" && !is_co64) {
+      continue;
+    }
+
+    size_t p = box.payload();
+    if (box.end() - p < 8) {
+      return false;
+    }
+    size_t entry_size = is_co64 ? 8 : 4;
+    uint64_t count = be32(moov, p + 4);
+    if (count > (box.end() - p - 8) / entry_size) {
+      return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      size_t entry = p + 8 + i * entry_size;
+      uint64_t offset = is_co64 ? be64(moov, entry) : be32(moov, entry);
+      if (offset < from || offset >= to) {
+        continue;
+      }
+      offset += delta;
+      if (is_co64) {
+        put_be64(moov, entry, offset);
+      } else if (offset > UINT32_MAX) {
+        return false;
+      } else {
+        put_be32(moov, entry, static_cast<uint32_t>(offset));
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// 解析 MP4 的时长、分辨率和编码
+bool parse_mp4(std::string_view data, Mp4Info &info) {
+  Box ftyp, moov;
+  if (!read_box(data, 0, data.size(), ftyp) || ftyp.type != "ftyp" ||
+      !find_box(data, 0, data.size(), "moov", moov)) {
+    return false;
+  }
+
+  Box mvhd;
+  if (find_child(data, moov, "mvhd", mvhd)) {
+    read_movie_header(data, mvhd, info);
+  }
+  Box box;
+  for (size_t pos = moov.payload();
+       pos < moov.end() && read_box(data, pos, moov.end(), box);
+       pos += box.size) {
+    if (box.type == "trak") {
+      read_track(data, box, info);
+    }
+  }
+  return true;
+}
+
+// 生成 moov 前置的新布局
+bool plan_mp4_faststart(std::string_view data, std::string &moov,
+                        std::vector<std::string_view> &pieces) {
+  // 顶层盒必须完整覆盖整个文件，只处理单个 moov、非分片的文件
+  Box box, moov_box;
+  bool has_moov = false, has_mdat = false;
+  size_t mdat_offset = 0;
+  for (size_t pos = 0; pos < data.size(); pos += box.size) {
+    if (!read_box(data, pos, data.size(), box) || box.type == "moof") {
+      return false;
+    }
+    if (box.type == "moov") {
+      if (has_moov) {
+        return false;
+      }
+      moov_box = box;
+      has_moov = true;
+    } else if (box.type == "mdat" && !has_mdat) {
+      mdat_offset = box.offset;
+      has_mdat = true;
+    }
+  }
+  // moov 已在 mdat 之前，或 moov 使用“延伸到末尾”的长度无法移动
+  if (!has_moov || !has_mdat || moov_box.offset < mdat_offset ||
+      be32(data, moov_box.offset) == 0) {
+    return false;
+  }
+
+  // moov 插入到第一个 mdat 之前后，[mdat 位置, moov 原位置) 之间的数据
+  // 整体后移 moov 的长度，moov 原位置之后的数据位置不变
+  moov.assign(data.substr(moov_box.offset, moov_box.size));
+  if (!shift_chunk_offsets(moov, 0, moov.size(), mdat_offset, moov_box.offset,
+                           moov.size())) {
+    return false;
+  }
+
+  pieces = {data.substr(0, mdat_offset), moov,
+            data.substr(mdat_offset, moov_box.offset - mdat_offset),
+            data.substr(moov_box.end())};
+  return true;
+}
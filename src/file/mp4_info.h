@@ -0,0 +1,28 @@
+#ifndef MP4_INFO_H
+#define MP4_INFO_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MP4 / QuickTime 文件的基本信息
+struct Mp4Info {
+  double duration = 0; // 时长（秒）
+  int width = 0;       // 第一条视频轨道的显示宽高
+  int height = 0;
+  std::string video_codec; // 采样描述的四字符代码，如 "avc1"、"hvc1"
+  std::string audio_codec; // 如 "mp4a"、"Opus"
+};
+
+// 解析顶层盒结构和 moov 盒，取得时长、分辨率和编码；
+// 不是完整的 MP4 或没有 moov 盒时返回 false
+bool parse_mp4(std::string_view data, Mp4Info &info);
+
+// moov 盒位于 mdat 之后时，生成把 moov 移到第一个 mdat 之前（fast-start）
+// 的新布局：moov 为修正了 stco/co64 偏移后的 moov 盒，
+// pieces 为按新顺序排列的数据片段（除 moov 外均直接引用 data）；
+// 不需要或无法调整时返回 false
+bool plan_mp4_faststart(std::string_view data, std::string &moov,
+                        std::vector<std::string_view> &pieces);
+
+#endif // MP4_INFO_H
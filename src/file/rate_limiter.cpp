@@ -0,0 +1,93 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <thread>
+
+TokenBucket::TokenBucket(double rate)
+    : rate_(rate), tokens_(rate), last_(std::chrono::steady_clock::now()) {}
+
+// 预先扣除令牌：令牌可以透支，透支部分按速率折算为等待时间，
+// 因此多个连接共享同一个桶时按请求先后排队
+std::chrono::nanoseconds TokenBucket::reserve(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - last_).count();
+  last_ = now;
+
+  tokens_ = (std::min)(rate_, tokens_ + elapsed * rate_);
+  tokens_ -= static_cast<double>(bytes);
+  if (tokens_ >= 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::nanoseconds(
+      static_cast<long long>(-tokens_ / rate_ * 1e9));
+}
+
+Throttle::Throttle(double connection_rate, std::shared_ptr<TokenBucket> global)
+    : global_(std::move(global)) {
+  if (connection_rate > 0) {
+    connection_ = std::make_unique<TokenBucket>(connection_rate);
+  }
+}
+
+// 申请工作线程名额
+bool Throttle::admit() {
+  if (!lease_) {
+    lease_ = acquire_worker_lease();
+  }
+  return lease_ != nullptr;
+}
+
+// 阻塞直到两个令牌桶都允许发送
+void Throttle::acquire(size_t bytes) {
+  std::chrono::nanoseconds wait(0);
+  if (connection_) {
+    wait = connection_->reserve(bytes);
+  }
+  if (global_) {
+    wait = (std::max)(wait, global_->reserve(bytes));
+  }
+  if (wait.count() > 0) {
+    std::this_thread::sleep_for(wait);
+  }
+}
+
+// 创建该类型所有下载共享的全局令牌桶，不限速时返回 nullptr
+static std::shared_ptr<TokenBucket> make_global_bucket(double rate) {
+  return rate > 0 ? std::make_shared<TokenBucket>(rate) : nullptr;
+}
+
+// 判断指定文件类型的下载是否限速
+bool is_rate_limited(const std::string &file_type) {
+  if (file_type == "video") {
+    return VIDEO_CONNECTION_RATE > 0 || VIDEO_GLOBAL_RATE > 0;
+  }
+  if (file_type == "image") {
+    return IMAGE_CONNECTION_RATE > 0 || IMAGE_GLOBAL_RATE > 0;
+  }
+  return OTHER_CONNECTION_RATE > 0 || OTHER_GLOBAL_RATE > 0;
+}
+
+// 为指定文件类型的下载创建限速器
+std::shared_ptr<Throttle> make_throttle(const std::string &file_type) {
+  static const auto video_global = make_global_bucket(VIDEO_GLOBAL_RATE);
+  static const auto image_global = make_global_bucket(IMAGE_GLOBAL_RATE);
+  static const auto other_global = make_global_bucket(OTHER_GLOBAL_RATE);
+
+  double connection_rate;
+  std::shared_ptr<TokenBucket> global;
+  if (file_type == "video") {
+    connection_rate = VIDEO_CONNECTION_RATE;
+    global = video_global;
+  } else if (file_type == "image") {
+    connection_rate = IMAGE_CONNECTION_RATE;
+    global = image_global;
+  } else {
+    connection_rate = OTHER_CONNECTION_RATE;
+    global = other_global;
+  }
+
+  if (connection_rate <= 0 && !global) {
+    return nullptr;
+  }
+  return std::make_shared<Throttle>(connection_rate, global);
+}
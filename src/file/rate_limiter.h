@@ -0,0 +1,62 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include "../worker_budget.h"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 按文件类型（image/video/other）配置的下载限速，单位 字节/秒，0 表示不限速
+// CONNECTION 为单个下载连接的上限，GLOBAL 为该类型所有下载合计的上限
+#define VIDEO_CONNECTION_RATE (4 * 1024 * 1024) // 4MB/s
+#define VIDEO_GLOBAL_RATE (32 * 1024 * 1024)    // 32MB/s
+#define IMAGE_CONNECTION_RATE 0
+#define IMAGE_GLOBAL_RATE 0
+#define OTHER_CONNECTION_RATE 0
+#define OTHER_GLOBAL_RATE 0
+
+// 每次等待令牌后最多发送的字节数（限速的粒度）
+#define RATE_LIMIT_CHUNK_SIZE (64 * 1024)
+
+// 令牌桶：按固定速率补充令牌，最多积累 1 秒的令牌（允许短时突发）
+class TokenBucket {
+public:
+  explicit TokenBucket(double rate);
+
+  // 预先扣除 bytes 个令牌，返回令牌不足时需要等待的时间
+  std::chrono::nanoseconds reserve(size_t bytes);
+
+private:
+  std::mutex mutex_;
+  double rate_;
+  double tokens_;
+  std::chrono::steady_clock::time_point last_;
+};
+
+// 一次下载的限速器：同时受单连接和全局两个令牌桶限制
+class Throttle {
+public:
+  Throttle(double connection_rate, std::shared_ptr<TokenBucket> global);
+
+  // 申请工作线程名额：等待令牌时 sleep 会占用工作线程，限速下载在整个
+  // 传输期间都计入与 SSE 连接共享的名额，名额已满时返回 false
+  bool admit();
+
+  // 阻塞直到允许发送 bytes 字节
+  void acquire(size_t bytes);
+
+private:
+  std::unique_ptr<TokenBucket> connection_;
+  std::shared_ptr<TokenBucket> global_;
+  std::shared_ptr<WorkerLease> lease_;
+};
+
+// 指定文件类型的下载是否限速
+bool is_rate_limited(const std::string &file_type);
+
+// 为指定文件类型的下载创建限速器，该类型不限速时返回 nullptr
+std::shared_ptr<Throttle> make_throttle(const std::string &file_type);
+
+#endif // RATE_LIMITER_H
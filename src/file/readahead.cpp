@@ -0,0 +1,72 @@
+#include "readahead.h"
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// 上一次请求结束时的状态
+struct AccessRecord {
+  size_t end = 0;        // 读到的位置
+  size_t prefetched = 0; // 已预读到的位置
+  size_t window = 0;     // 预读窗口
+  std::list<std::string>::iterator lru_pos;
+};
+
+std::mutex tracker_mutex;
+std::list<std::string> lru; // 头部为最近使用
+std::unordered_map<std::string, AccessRecord> records;
+
+} // namespace
+
+Readahead::Readahead(std::string key, size_t offset, size_t file_size)
+    : key_(std::move(key)), file_size_(file_size), pos_(offset),
+      prefetched_(offset), window_(READAHEAD_MIN_WINDOW) {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  auto it = records.find(key_);
+  if (it == records.end()) {
+    return;
+  }
+  // 起点落在上次结束位置附近（允许一个最大窗口的误差）视为顺序访问
+  size_t end = it->second.end;
+  size_t distance = offset > end ? offset - end : end - offset;
+  if (distance <= READAHEAD_MAX_WINDOW) {
+    window_ = it->second.window;
+    prefetched_ = (std::max)(offset, it->second.prefetched);
+  }
+}
+
+Readahead::~Readahead() {
+  std::lock_guard<std::mutex> lock(tracker_mutex);
+  auto it = records.find(key_);
+  if (it != records.end()) {
+    lru.erase(it->second.lru_pos);
+  }
+  lru.push_front(key_);
+  records[key_] = {pos_, prefetched_, window_, lru.begin()};
+
+  while (records.size() > READAHEAD_TRACKER_SIZE) {
+    records.erase(lru.back());
+    lru.pop_back();
+  }
+}
+
+// 保持预读位置领先读取位置一到两个窗口，每次补充预读后窗口翻倍
+bool Readahead::next(size_t offset, size_t &from, size_t &length) {
+  pos_ = offset;
+  if (offset + window_ <= prefetched_ || prefetched_ >= file_size_) {
+    return false;
+  }
+
+  from = (std::max)(prefetched_, offset);
+  size_t to = (std::min)(offset + 2 * window_, file_size_);
+  if (from >= to) {
+    return false;
+  }
+  length = to - from;
+  prefetched_ = to;
+  window_ = (std::min)(window_ * 2, static_cast<size_t>(READAHEAD_MAX_WINDOW));
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <cstddef>
+#include <string>
+
+// 预读窗口的初始大小和上限：连续的顺序访问每次将窗口翻倍
+#define READAHEAD_MIN_WINDOW (1 * 1024 * 1024)  // 1MB
+#define READAHEAD_MAX_WINDOW (16 * 1024 * 1024) // 16MB
+// 最多跟踪的 客户端+文件 组合数
+#define READAHEAD_TRACKER_SIZE 1024
+
+// 一次区间请求的预读状态：
+// 若请求的起点与同一客户端对同一文件的上一次请求的结束位置衔接（顺序播放），
+// 沿用上次已扩大的预读窗口；否则（拖动进度条）从最小窗口重新开始。
+// 析构时记录本次读到的位置，供下一次请求判断是否顺序访问
+class Readahead {
+public:
+  Readahead(std::string key, size_t offset, size_t file_size);
+  ~Readahead();
+
+  Readahead(const Readahead &) = delete;
+  Readahead &operator=(const Readahead &) = delete;
+
+  // 即将读取 offset 处的数据；需要预读时返回 true，
+  // 并通过 from/length 给出应异步预读的区间
+  bool next(size_t offset, size_t &from, size_t &length);
+
+private:
+  std::string key_;
+  size_t file_size_;
+  size_t pos_;        // 最近一次读取的位置
+  size_t prefetched_; // 已预读到的位置
+  size_t window_;     // 当前预读窗口
+};
+
+#endif // READAHEAD_H
@@ -0,0 +1,28 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SHA-256 摘要计算（支持分块输入）
+class Sha256 {
+public:
+  Sha256();
+
+  // 追加一段数据
+  void update(const void *data, size_t len);
+
+  // 结束计算，返回 64 位十六进制小写摘要
+  std::string hex_digest();
+
+private:
+  void transform(const uint8_t *block);
+
+  uint32_t state_[8];
+  uint64_t bit_count_ = 0;
+  uint8_t buffer_[64];
+  size_t buffer_len_ = 0;
+};
+
+#endif // SHA256_H
@@ -0,0 +1,50 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 合并并发的相同操作：同一个 key 同一时刻只执行一次，
+// 执行期间到达的其他调用者等待并共享同一个结果（或异常）
+template <typename T> class SingleFlight {
+public:
+  T run(const std::string &key, const std::function<T()> &fn) {
+    std::promise<T> promise;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto it = calls_.find(key);
+      if (it != calls_.end()) {
+        std::shared_future<T> result = it->second;
+        lock.unlock();
+        return result.get();
+      }
+      calls_[key] = promise.get_future().share();
+    }
+
+    // 先移出等待表再发布结果，之后到达的调用者会重新执行
+    try {
+      T value = fn();
+      finish(key);
+      promise.set_value(value);
+      return value;
+    } catch (...) {
+      finish(key);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+  }
+
+private:
+  void finish(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    calls_.erase(key);
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_future<T>> calls_;
+};
+
+#endif // SINGLE_FLIGHT_H
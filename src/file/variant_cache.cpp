@@ -0,0 +1,307 @@
+#include "variant_cache.h"
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct VariantEntry {
+  uintmax_t size;
+  std::list<std::string>::iterator lru_pos;
+};
+
+// 变体索引：按最近使用顺序淘汰，总大小不超过 VARIANT_CACHE_MAX_BYTES
+std::mutex cache_mutex;
+bool cache_loaded = false;
+std::list<std::string> lru; // 头部为最近使用
+std::unordered_map<std::string, VariantEntry> entries;
+uintmax_t total_bytes = 0;
+
+// 正在生成中的变体，后到的相同请求等待同一个结果
+std::unordered_map<std::string, std::shared_future<bool>> inflight;
+
+// 每个源文件的版本号，删除时递增，用于丢弃删除前开始生成的结果
+std::unordered_map<std::string, unsigned> epochs;
+
+// 生成失败的变体（如无法解码的图片），源文件失效前直接返回失败
+std::unordered_set<std::string> failed;
+
+// 正在生成的变体数，不超过 VARIANT_MAX_CONCURRENT
+std::condition_variable slot_cv;
+int generating = 0;
+
+// 后台生成队列，由唯一的工作线程依次处理
+struct VariantTask {
+  std::string filename;
+  std::string variant;
+  VariantGenerator generate;
+};
+std::condition_variable queue_cv;
+std::deque<VariantTask> queue;
+std::unordered_set<std::string> queued; // 已在队列中或正在后台生成的变体
+bool worker_started = false;
+
+} // namespace
+
+static fs::path variant_path(const std::string &key) {
+  return fs::path(VARIANT_CACHE_DIR) / key;
+}
+
+// 首次使用时扫描缓存目录，恢复已有的变体（需持有锁）
+static void load_cache_locked() {
+  if (cache_loaded) {
+    return;
+  }
+  cache_loaded = true;
+
+  std::error_code ec;
+  fs::path root(VARIANT_CACHE_DIR);
+  if (!fs::exists(root, ec)) {
+    return;
+  }
+  for (const auto &entry : fs::recursive_directory_iterator(root, ec)) {
+    if (!entry.is_regular_file(ec)) {
+      continue;
+    }
+    std::string key = entry.path().lexically_relative(root).generic_string();
+    if (entry.path().extension() == ".tmp") {
+      fs::remove(entry.path(), ec); // 上次未完成的临时文件
+      continue;
+    }
+    uintmax_t size = entry.file_size(ec);
+    lru.push_back(key);
+    entries[key] = {size, std::prev(lru.end())};
+    total_bytes += size;
+  }
+}
+
+// 淘汰最久未使用的变体直到总大小低于上限（需持有锁）
+static void evict_locked(const std::string &keep) {
+  while (total_bytes > static_cast<uintmax_t>(VARIANT_CACHE_MAX_BYTES) &&
+         !lru.empty()) {
+    std::string victim = lru.back();
+    if (victim == keep) {
+      break;
+    }
+    lru.pop_back();
+    total_bytes -= entries[victim].size;
+    entries.erase(victim);
+
+    std::error_code ec;
+    fs::remove(variant_path(victim), ec);
+  }
+}
+
+// 生成变体并原子地写入缓存目录（先写临时文件再重命名），
+// 生成函数分块写入临时文件，变体内容不会整体放在内存中
+static bool write_variant(const std::string &key,
+                          const VariantGenerator &generate, uintmax_t &size) {
+  fs::path path = variant_path(key);
+  fs::path tmp_path = path;
+  tmp_path += ".tmp";
+
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+
+  std::ofstream ofs(tmp_path, std::ios::binary);
+  if (!ofs.is_open()) {
+    return false;
+  }
+
+  size = 0;
+  bool ok;
+  try {
+    ok = generate([&ofs, &size](const char *data, size_t len) {
+      ofs.write(data, static_cast<std::streamsize>(len));
+      size += len;
+      return static_cast<bool>(ofs);
+    });
+  } catch (const std::exception &e) {
+    std::cerr << "Failed to generate variant " << key << ": " << e.what()
+              << std::endl;
+    ok = false;
+  }
+  ofs.close();
+  if (!ok || !ofs) {
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+// 查找或生成文件的派生变体（如缩放后的图片），并发的相同请求只生成一次
+bool get_or_create_variant(const std::string &filename,
+                           const std::string &variant,
+                           const VariantGenerator &generate,
+                           fs::path &out_path) {
+  std::string key = filename + "/" + variant;
+  std::promise<bool> promise;
+  unsigned epoch;
+
+  {
+    std::unique_lock<std::mutex> lock(cache_mutex);
+    load_cache_locked();
+
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+      lru.splice(lru.begin(), lru, it->second.lru_pos);
+      out_path = variant_path(key);
+      return true;
+    }
+
+    if (failed.count(key)) {
+      return false;
+    }
+
+    auto pending = inflight.find(key);
+    if (pending != inflight.end()) {
+      std::shared_future<bool> result = pending->second;
+      lock.unlock();
+      if (!result.get()) {
+        return false;
+      }
+      out_path = variant_path(key);
+      return true;
+    }
+
+    inflight[key] = promise.get_future().share();
+    epoch = epochs[filename];
+
+    // 限制同时生成的数量，避免并发请求不同变体时内存占用成倍增长
+    slot_cv.wait(lock, [] { return generating < VARIANT_MAX_CONCURRENT; });
+    generating++;
+  }
+
+  uintmax_t size = 0;
+  bool ok = write_variant(key, generate, size);
+
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    generating--;
+    inflight.erase(key);
+    if (epochs[filename] != epoch) {
+      // 生成期间源文件已被删除，结果作废
+      if (ok) {
+        std::error_code ec;
+        fs::remove(variant_path(key), ec);
+        ok = false;
+      }
+    } else if (ok) {
+      lru.push_front(key);
+      entries[key] = {size, lru.begin()};
+      total_bytes += size;
+      evict_locked(key);
+    } else {
+      if (failed.size() >= VARIANT_FAILED_MAX) {
+        failed.clear();
+      }
+      failed.insert(key);
+    }
+  }
+  slot_cv.notify_one();
+
+  promise.set_value(ok);
+  if (ok) {
+    out_path = variant_path(key);
+  }
+  return ok;
+}
+
+// 查找已生成的变体（不触发生成），命中时返回 true
+bool find_variant(const std::string &filename, const std::string &variant,
+                  fs::path &out_path) {
+  std::string key = filename + "/" + variant;
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  load_cache_locked();
+
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    return false;
+  }
+  lru.splice(lru.begin(), lru, it->second.lru_pos);
+  out_path = variant_path(key);
+  return true;
+}
+
+// 后台工作线程：依次生成队列中的变体
+static void run_variant_worker() {
+  std::unique_lock<std::mutex> lock(cache_mutex);
+  while (true) {
+    queue_cv.wait(lock, [] { return !queue.empty(); });
+    VariantTask task = std::move(queue.front());
+    queue.pop_front();
+    lock.unlock();
+
+    fs::path path;
+    get_or_create_variant(task.filename, task.variant, task.generate, path);
+
+    lock.lock();
+    queued.erase(task.filename + "/" + task.variant);
+  }
+}
+
+// 交给后台工作线程生成变体
+void create_variant_async(const std::string &filename,
+                          const std::string &variant,
+                          VariantGenerator generate) {
+  std::string key = filename + "/" + variant;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    load_cache_locked();
+    if (entries.count(key) || inflight.count(key) || queued.count(key) ||
+        failed.count(key) || queue.size() >= VARIANT_QUEUE_MAX) {
+      return;
+    }
+    queue.push_back({filename, variant, std::move(generate)});
+    queued.insert(key);
+    if (!worker_started) {
+      worker_started = true;
+      std::thread(run_variant_worker).detach();
+    }
+  }
+  queue_cv.notify_one();
+}
+
+// 删除某个文件的所有派生变体
+void remove_variants(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  load_cache_locked();
+  epochs[filename]++;
+
+  std::string prefix = filename + "/";
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0) {
+      total_bytes -= it->second.size;
+      lru.erase(it->second.lru_pos);
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = failed.begin(); it != failed.end();) {
+    if (it->compare(0, prefix.size(), prefix) == 0) {
+      it = failed.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::error_code ec;
+  fs::remove_all(variant_path(filename), ec);
+}
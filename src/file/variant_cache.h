@@ -0,0 +1,50 @@
+#ifndef VARIANT_CACHE_H
+#define VARIANT_CACHE_H
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+// 派生变体缓存目录及容量上限
+#define VARIANT_CACHE_DIR "cache/variants"
+#define VARIANT_CACHE_MAX_BYTES (512LL * 1024 * 1024) // 512MB
+
+// 后台生成队列的最大长度，队列已满时新的生成请求直接丢弃
+#define VARIANT_QUEUE_MAX 32
+
+// 同时生成的变体数上限（含后台生成），单个生成（如解码大图）可能占用上百 MB 内存，
+// 超出时请求等待空闲名额
+#define VARIANT_MAX_CONCURRENT 2
+
+// 记录的生成失败变体数上限，超出时清空重新记录
+#define VARIANT_FAILED_MAX 1024
+
+// 变体内容的输出函数：按块写入变体文件，失败返回 false
+using VariantWriter = std::function<bool(const char *data, size_t len)>;
+// 变体生成函数：通过 write 分块输出变体内容（不需要把整个变体放在内存中），
+// 失败返回 false
+using VariantGenerator = std::function<bool(const VariantWriter &write)>;
+
+// 查找或生成文件的派生变体（如缩放后的图片），并发的相同请求只生成一次；
+// 生成失败的变体会被记住，源文件失效之前不再重复生成
+// variant 为变体名（如 "w320.png"），成功时通过 out_path 返回变体文件路径
+bool get_or_create_variant(const std::string &filename,
+                           const std::string &variant,
+                           const VariantGenerator &generate,
+                           std::filesystem::path &out_path);
+
+// 查找已生成的变体（不触发生成），命中时返回 true
+bool find_variant(const std::string &filename, const std::string &variant,
+                  std::filesystem::path &out_path);
+
+// 交给后台工作线程生成变体：所有后台生成共用一个线程依次执行，
+// 变体已存在、正在生成、已在队列中、曾经生成失败或队列已满时直接返回
+void create_variant_async(const std::string &filename,
+                          const std::string &variant,
+                          VariantGenerator generate);
+
+// 删除某个文件的所有派生变体，并清除其生成失败记录
+void remove_variants(const std::string &filename);
+
+#endif // VARIANT_CACHE_H
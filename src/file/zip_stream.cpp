@@ -0,0 +1,121 @@
+#include "zip_stream.h"
+#include <zlib.h>
+
+// 通用标志：第 3 位表示使用数据描述符，第 11 位表示文件名为 UTF-8
+#define ZIP_FLAGS 0x0808
+#define ZIP_VERSION 20
+
+static void put16(std::string &out, uint16_t v) {
+  out.push_back(static_cast<char>(v & 0xFF));
+  out.push_back(static_cast<char>(v >> 8));
+}
+
+static void put32(std::string &out, uint32_t v) {
+  put16(out, static_cast<uint16_t>(v & 0xFFFF));
+  put16(out, static_cast<uint16_t>(v >> 16));
+}
+
+// 开始一个新条目，返回本地文件头
+std::string ZipStream::begin_entry(const std::string &name, time_t mtime) {
+  current_ = Record();
+  current_.name = name;
+  current_.offset = static_cast<uint32_t>(offset_);
+  current_.crc = static_cast<uint32_t>(crc32(0L, Z_NULL, 0));
+
+  // MS-DOS 格式的修改时间（本地时间，精度 2 秒，最早 1980 年）
+  struct tm tm_value = {};
+#ifdef _WIN32
+  localtime_s(&tm_value, &mtime);
+#else
+  localtime_r(&mtime, &tm_value);
+#endif
+  if (tm_value.tm_year >= 80) {
+    current_.dos_time = static_cast<uint16_t>(
+        (tm_value.tm_hour << 11) | (tm_value.tm_min << 5) |
+        (tm_value.tm_sec / 2));
+    current_.dos_date = static_cast<uint16_t>(((tm_value.tm_year - 80) << 9) |
+                                              ((tm_value.tm_mon + 1) << 5) |
+                                              tm_value.tm_mday);
+  } else {
+    current_.dos_date = (1 << 5) | 1; // 1980-01-01
+  }
+
+  // CRC 和大小在数据描述符中给出，本地文件头中置 0
+  std::string header;
+  put32(header, 0x04034b50);
+  put16(header, ZIP_VERSION);
+  put16(header, ZIP_FLAGS);
+  put16(header, 0); // 存储模式
+  put16(header, current_.dos_time);
+  put16(header, current_.dos_date);
+  put32(header, 0);
+  put32(header, 0);
+  put32(header, 0);
+  put16(header, static_cast<uint16_t>(name.size()));
+  put16(header, 0); // 扩展字段长度
+  header += name;
+
+  offset_ += header.size();
+  return header;
+}
+
+// 输入当前条目的一段数据
+void ZipStream::update(const char *data, size_t len) {
+  current_.crc = static_cast<uint32_t>(
+      crc32(current_.crc, reinterpret_cast<const Bytef *>(data),
+            static_cast<uInt>(len)));
+  current_.size += static_cast<uint32_t>(len);
+  offset_ += len;
+}
+
+// 结束当前条目，返回数据描述符
+std::string ZipStream::end_entry() {
+  std::string descriptor;
+  put32(descriptor, 0x08074b50);
+  put32(descriptor, current_.crc);
+  put32(descriptor, current_.size); // 压缩后大小（存储模式下与原始大小相同）
+  put32(descriptor, current_.size);
+
+  offset_ += descriptor.size();
+  records_.push_back(current_);
+  return descriptor;
+}
+
+// 结束归档，返回中央目录和结束记录
+std::string ZipStream::finish() {
+  std::string out;
+  uint32_t directory_offset = static_cast<uint32_t>(offset_);
+  for (const auto &record : records_) {
+    put32(out, 0x02014b50);
+    put16(out, ZIP_VERSION); // 创建版本
+    put16(out, ZIP_VERSION); // 解压所需版本
+    put16(out, ZIP_FLAGS);
+    put16(out, 0);
+    put16(out, record.dos_time);
+    put16(out, record.dos_date);
+    put32(out, record.crc);
+    put32(out, record.size);
+    put32(out, record.size);
+    put16(out, static_cast<uint16_t>(record.name.size()));
+    put16(out, 0); // 扩展字段长度
+    put16(out, 0); // 注释长度
+    put16(out, 0); // 磁盘编号
+    put16(out, 0); // 内部属性
+    put32(out, 0); // 外部属性
+    put32(out, record.offset);
+    out += record.name;
+  }
+  uint32_t directory_size = static_cast<uint32_t>(out.size());
+
+  put32(out, 0x06054b50);
+  put16(out, 0);
+  put16(out, 0);
+  put16(out, static_cast<uint16_t>(records_.size()));
+  put16(out, static_cast<uint16_t>(records_.size()));
+  put32(out, directory_size);
+  put32(out, directory_offset);
+  put16(out, 0); // 注释长度
+
+  offset_ += out.size();
+  return out;
+}
@@ -0,0 +1,49 @@
+#ifndef ZIP_STREAM_H
+#define ZIP_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+// 不使用 ZIP64 扩展时归档的最大大小
+#define ZIP_MAX_ARCHIVE_SIZE 0xFFFFFFFFULL
+// 单个条目的固定开销（本地文件头、数据描述符、中央目录项，不含文件名）
+#define ZIP_ENTRY_OVERHEAD (30 + 16 + 46)
+// 中央目录结束记录的大小
+#define ZIP_END_RECORD_SIZE 22
+
+// 流式生成存储模式（不压缩）的 zip 归档：
+// 条目数据之后写入数据描述符，CRC 和大小在发送数据的同时计算，
+// 不需要预先读取文件或在磁盘上暂存归档
+class ZipStream {
+public:
+  // 开始一个新条目，返回本地文件头
+  std::string begin_entry(const std::string &name, time_t mtime);
+
+  // 输入当前条目的一段数据（只计算 CRC 和大小，数据由调用方直接发送）
+  void update(const char *data, size_t len);
+
+  // 结束当前条目，返回数据描述符
+  std::string end_entry();
+
+  // 结束归档，返回中央目录和结束记录
+  std::string finish();
+
+private:
+  struct Record {
+    std::string name;
+    uint32_t crc = 0;
+    uint32_t size = 0;
+    uint32_t offset = 0; // 本地文件头在归档中的偏移
+    uint16_t dos_time = 0;
+    uint16_t dos_date = 0;
+  };
+
+  std::vector<Record> records_;
+  Record current_;
+  uint64_t offset_ = 0; // 已输出的字节数
+};
+
+#endif // ZIP_STREAM_H
@@ -1,4 +1,5 @@
 #include "routes.h"
+#include "worker_budget.h"
 #include <httplib.h>
 #include <iostream>
 #include <json.hpp>
@@ -10,6 +11,9 @@ using json = nlohmann::json;
 int main() {
   // 创建服务器实例
   httplib::Server server;
+  server.new_task_queue = [] {
+    return new httplib::ThreadPool(THREAD_POOL_SIZE);
+  };
 
   // 配置CORS支持 - 在所有响应后添加CORS头
   server.set_post_routing_handler(
@@ -1,4 +1,5 @@
 #include "routes.h"
+#include "event/event_routes.h"
 #include "file/file_routes.h"
 #include "test/test_routes.h"
 
@@ -9,4 +10,7 @@ void configure_routes(httplib::Server &server) {
 
   // 配置文件操作路由
   configure_file_routes(server);
+
+  // 配置事件推送路由
+  configure_event_routes(server);
 }
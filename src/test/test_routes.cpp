@@ -1,12 +1,22 @@
 #include "test_routes.h"
-#include <algorithm>
+#include "../worker_budget.h"
 #include <chrono>
+#include <filesystem>
 #include <fstream>
 #include <httplib.h>
+#include <iostream>
 #include <json.hpp>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 using json = nlohmann::json;
 
@@ -16,106 +26,206 @@ void handle_test([[maybe_unused]] const httplib::Request &req,
   res.set_content(body, "application/json; charset=utf-8");
 }
 
-struct StreamState {
+// 流式返回的源文件及其分隔符
+static const char *const TEST_SOURCE_FILES[] = {
+    "test/index.html", "test/main.js", "test/style.css"};
+static const char *const TEST_SOURCE_SEPARATORS[] = {
+    "===index.html===\n", "\n===index.js===\n", "\n===index.css===\n"};
+#define TEST_SOURCE_COUNT 3
+
+// 每个数据块的最大字节数
+#define TEST_STREAM_CHUNK_SIZE 100
+
+// 预先序列化好的 SSE 帧（起始、数据块、结束），所有请求共享同一份只读数据
+struct StreamPayload {
+  std::vector<std::string> frames;
+};
+
+// 帧只在源文件变化后构建一次，下一个请求重新构建
+static std::mutex payload_mutex;
+static std::shared_ptr<const StreamPayload> payload_cache;
+static bool payload_watching = false;
+static std::filesystem::file_time_type source_mtimes[TEST_SOURCE_COUNT];
+
+// 监听 test 目录（Linux 下使用 inotify），任一源文件变化时清空缓存；
+// 当前平台不支持或监听失败时返回 false
+static bool watch_test_sources() {
+#ifdef __linux__
+  int fd = inotify_init1(IN_CLOEXEC);
+  if (fd == -1 || inotify_add_watch(fd, "test",
+                                    IN_CLOSE_WRITE | IN_DELETE |
+                                        IN_MOVED_FROM | IN_MOVED_TO |
+                                        IN_ATTRIB) == -1) {
+    std::cerr << "Warning: failed to watch test directory" << std::endl;
+    if (fd != -1) {
+      ::close(fd);
+    }
+    return false;
+  }
+
+  std::thread([fd]() {
+    alignas(struct inotify_event) char buffer[4096];
+    while (true) {
+      ssize_t len = ::read(fd, buffer, sizeof(buffer));
+      if (len <= 0) {
+        break;
+      }
+      // 目录内文件很少，任何事件都直接清空缓存
+      std::lock_guard<std::mutex> lock(payload_mutex);
+      payload_cache.reset();
+    }
+    ::close(fd);
+  }).detach();
+  return true;
+#else
+  return false;
+#endif
+}
+
+// 无法监听时退化为比较修改时间（每次请求三次 stat，不读取内容）
+static bool test_sources_changed() {
+  for (size_t i = 0; i < TEST_SOURCE_COUNT; ++i) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(TEST_SOURCE_FILES[i], ec);
+    if (ec || mtime != source_mtimes[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// 从 pos 开始取不超过 max_len 字节且不截断 UTF-8 字符的长度：
+// 只需从切分点向前最多检查 3 个字节，找到被截断字符的起始字节
+static size_t utf8_chunk_length(std::string_view data, size_t pos,
+                                size_t max_len) {
+  size_t end = pos + max_len;
+  if (end >= data.size()) {
+    return data.size() - pos;
+  }
+  auto is_continuation = [&data](size_t i) {
+    return (static_cast<unsigned char>(data[i]) & 0xC0) == 0x80;
+  };
+  size_t start = end;
+  while (start > pos && end - start < 3 && is_continuation(start)) {
+    --start;
+  }
+  // 非法序列时按原长度切分，序列化时替换为 U+FFFD
+  if (start == pos || is_continuation(start)) {
+    return max_len;
+  }
+  return start - pos;
+}
+
+static std::string sse_frame(const json &data) {
+  return "data: " +
+         data.dump(-1, ' ', false, json::error_handler_t::replace) + "\n\n";
+}
+
+// 把合并后的内容切分为数据块并一次性序列化为 SSE 帧，总开销与内容长度成正比
+static std::shared_ptr<const StreamPayload>
+build_stream_payload(const std::string &merged) {
+  auto payload = std::make_shared<StreamPayload>();
+  auto &frames = payload->frames;
+  frames.push_back(sse_frame({{"type", "start"},
+                              {"total", merged.size()},
+                              {"chunk_size", TEST_STREAM_CHUNK_SIZE}}));
+  size_t pos = 0, chunk_index = 0;
+  while (pos < merged.size()) {
+    size_t chunk = utf8_chunk_length(merged, pos, TEST_STREAM_CHUNK_SIZE);
+    frames.push_back(sse_frame({{"type", "chunk"},
+                                {"index", chunk_index},
+                                {"content", merged.substr(pos, chunk)}}));
+    pos += chunk;
+    chunk_index++;
+  }
+  frames.push_back(sse_frame({{"type", "end"},
+                              {"total_chunks", chunk_index},
+                              {"total_bytes", pos}}));
+  return payload;
+}
+
+// 获取流式返回的帧，读取失败时返回 nullptr 并给出失败的文件路径
+static std::shared_ptr<const StreamPayload>
+get_stream_payload(std::string &failed_path) {
+  static std::once_flag watch_once;
+  std::call_once(watch_once, [] { payload_watching = watch_test_sources(); });
+
+  std::lock_guard<std::mutex> lock(payload_mutex);
+  if (payload_cache && (payload_watching || !test_sources_changed())) {
+    return payload_cache;
+  }
+
+  // 合并：用分隔符串联
   std::string merged;
-  size_t pos;
-  int phase; // 0=起始 1=数据 2=结束
-  size_t chunk_index;
-  static constexpr size_t CHUNK_SIZE = 100;
+  for (size_t i = 0; i < TEST_SOURCE_COUNT; ++i) {
+    std::ifstream ifs(TEST_SOURCE_FILES[i], std::ios::binary);
+    if (!ifs.is_open()) {
+      failed_path = TEST_SOURCE_FILES[i];
+      return nullptr;
+    }
+    std::error_code ec;
+    source_mtimes[i] =
+        std::filesystem::last_write_time(TEST_SOURCE_FILES[i], ec);
+    merged.append(TEST_SOURCE_SEPARATORS[i]);
+    merged.append(std::istreambuf_iterator<char>(ifs),
+                  std::istreambuf_iterator<char>());
+  }
+  payload_cache = build_stream_payload(merged);
+  return payload_cache;
+}
+
+struct StreamState {
+  std::shared_ptr<WorkerLease> lease; // 连接期间占用的工作线程名额
+  std::shared_ptr<const StreamPayload> payload;
+  size_t next_frame = 0;
 };
 
 // 流式返回：合并 index.html、main.js、style.css，用
 // ===index.html===、===index.js===、===index.css=== 分割
 void handle_test_stream([[maybe_unused]] const httplib::Request &req,
                         httplib::Response &res) {
-  std::string html_content, js_content, css_content;
-
-  auto read_file = [&res](const std::string &path, std::string &out) -> bool {
-    std::ifstream ifs(path, std::ios::binary);
-    if (!ifs.is_open()) {
-      res.status = 500;
-      res.set_content(json{{"error", "Failed to open file: " + path}}.dump(),
-                      "application/json; charset=utf-8");
-      return false;
-    }
-    out.assign((std::istreambuf_iterator<char>(ifs)),
-               std::istreambuf_iterator<char>());
-    return true;
-  };
-
-  if (!read_file("test/index.html", html_content) ||
-      !read_file("test/main.js", js_content) ||
-      !read_file("test/style.css", css_content)) {
+  std::string failed_path;
+  std::shared_ptr<const StreamPayload> payload =
+      get_stream_payload(failed_path);
+  if (!payload) {
+    res.status = 500;
+    res.set_content(
+        json{{"error", "Failed to open file: " + failed_path}}.dump(),
+        "application/json; charset=utf-8");
     return;
   }
 
-  // 合并：用分隔符串联
-  std::string merged = "===index.html===\n" + html_content +
-                       "\n===index.js===\n" + js_content +
-                       "\n===index.css===\n" + css_content;
+  // 流式响应在整个连接期间占用一个工作线程，被挂起的工作线程
+  // （SSE 连接和限速下载合计）达到上限时拒绝，避免占满工作线程
+  std::shared_ptr<WorkerLease> lease = acquire_worker_lease();
+  if (!lease) {
+    res.status = 503;
+    res.set_header("Retry-After", "1");
+    res.set_content("{\"error\":\"Too many event streams\"}",
+                    "application/json; charset=utf-8");
+    return;
+  }
 
   auto state = std::make_shared<StreamState>();
-  state->merged = std::move(merged);
-  state->pos = 0;
-  state->phase = 0;
-  state->chunk_index = 0;
+  state->lease = std::move(lease);
+  state->payload = std::move(payload);
 
   res.set_chunked_content_provider(
       "text/event-stream; charset=utf-8",
       [state]([[maybe_unused]] size_t offset, httplib::DataSink &sink) {
-        // 阶段 0：发送起始
-        if (state->phase == 0) {
-          json start = {{"type", "start"},
-                        {"total", state->merged.size()},
-                        {"chunk_size", StreamState::CHUNK_SIZE}};
-          std::string line = "data: " + start.dump() + "\n\n";
-          if (!sink.write(line.data(), line.size()))
-            return false;
-          state->phase = 1;
-          return true;
-        }
-
-        // 阶段 1：发送数据块
-        if (state->phase == 1) {
-          if (state->pos >= state->merged.size()) {
-            state->phase = 2;
-            return true;
-          }
+        const auto &frames = state->payload->frames;
+        // 起始帧立即发送，之后每帧间隔 10ms
+        if (state->next_frame > 0) {
           std::this_thread::sleep_for(std::chrono::milliseconds(10));
-          size_t chunk = (std::min)(StreamState::CHUNK_SIZE,
-                                    state->merged.size() - state->pos);
-          std::string chunk_str;
-          while (chunk > 0) {
-            chunk_str = state->merged.substr(state->pos, chunk);
-            try {
-              (void)json(chunk_str).dump();
-              break;
-            } catch (const json::exception &) {
-              chunk--;
-            }
-          }
-          if (chunk == 0)
-            return false;
-          json data = {{"type", "chunk"},
-                       {"index", state->chunk_index},
-                       {"content", chunk_str}};
-          std::string line = "data: " + data.dump() + "\n\n";
-          if (!sink.write(line.data(), line.size()))
-            return false;
-          state->pos += chunk;
-          state->chunk_index++;
-          return true;
         }
-
-        // 阶段 2：发送结束
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        json end = {{"type", "end"},
-                    {"total_chunks", state->chunk_index},
-                    {"total_bytes", state->pos}};
-        std::string line = "data: " + end.dump() + "\n\n";
-        if (!sink.write(line.data(), line.size()))
+        const std::string &frame = frames[state->next_frame++];
+        if (!sink.write(frame.data(), frame.size())) {
           return false;
-        return false;
+        }
+        if (state->next_frame == frames.size()) {
+          sink.done();
+        }
+        return true;
       },
       nullptr);
 }
@@ -0,0 +1,18 @@
+#include "worker_budget.h"
+#include <atomic>
+#include <cstddef>
+
+static std::atomic<size_t> leased_workers{0};
+
+WorkerLease::~WorkerLease() { --leased_workers; }
+
+// 申请工作线程名额
+std::shared_ptr<WorkerLease> acquire_worker_lease() {
+  size_t leased = leased_workers.load();
+  do {
+    if (leased >= PACED_WORKER_LIMIT) {
+      return nullptr;
+    }
+  } while (!leased_workers.compare_exchange_weak(leased, leased + 1));
+  return std::shared_ptr<WorkerLease>(new WorkerLease());
+}
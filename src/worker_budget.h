@@ -0,0 +1,28 @@
+#ifndef WORKER_BUDGET_H
+#define WORKER_BUDGET_H
+
+#include <memory>
+
+// 服务器工作线程数
+#define THREAD_POOL_SIZE 128
+// 同时被挂起等待的工作线程上限：httplib 的流式响应在整个连接期间占用一个
+// 工作线程，SSE 连接等待下一帧或新事件、限速下载等待令牌时线程都无法处理其他请求，
+// 这两类响应合计不超过该数量，超出时由调用方返回 503
+#define PACED_WORKER_LIMIT 96
+
+// 一个被挂起响应占用的工作线程名额，析构时归还
+class WorkerLease {
+public:
+  WorkerLease(const WorkerLease &) = delete;
+  WorkerLease &operator=(const WorkerLease &) = delete;
+  ~WorkerLease();
+
+private:
+  WorkerLease() = default;
+  friend std::shared_ptr<WorkerLease> acquire_worker_lease();
+};
+
+// 申请一个工作线程名额，已达上限时返回 nullptr
+std::shared_ptr<WorkerLease> acquire_worker_lease();
+
+#endif // WORKER_BUDGET_H